@@ -0,0 +1,231 @@
+/*
+ * Contains in-kernel microbenchmark registry and runner.
+ *
+ * Every benchmark is a function called 'iters' times per repetition.
+ * After BENCH_WARMUP repetitions, BENCH_REPS repetitions are timed with
+ * serialized rdtsc. Samples further than 3 median absolute deviations
+ * from median are rejected. Results are printed to serial port,
+ * one line per benchmark:
+ *
+ *   BENCH name=<name> iters=<n> kept=<n> min=<c> median=<c> mean=<c> max=<c> unit=cycles
+ *   SAMPLES name=<name> <c> <c> ...
+ *
+ * where <c> is cycles per one call with timing overhead subtracted.
+ */
+
+#include "bench.h"
+#include "memory.h"
+#include "printf.h"
+#include "screen.h"
+#include "serial.h"
+#include "string.h"
+#include "fb.h"
+#include "log.h"
+#include "time.h"
+
+struct bench {
+    const char* name;
+    bench_fn_t fn;
+    void* arg;
+    unsigned int iters;
+};
+
+static struct bench benches[BENCH_MAX];
+static int num_benches = 0;
+static unsigned int samples[BENCH_REPS];
+static unsigned int overhead = 0;   /* cycles spent by timing itself */
+
+/*
+ * Reads time stamp counter after all previous instructions complete.
+ * cpuid is a serializing instruction.
+ */
+static inline unsigned long long rdtsc_serialized() {
+    unsigned long long t;
+    __asm__ volatile (
+        "xorl %%eax, %%eax\n"
+        "cpuid\n"
+        "rdtsc\n"
+        : "=A"(t)
+        :
+        : "ebx", "ecx", "memory"
+    );
+    return t;
+}
+
+/*
+ * Registers benchmark 'name' calling 'fn(arg)' 'iters' times per repetition.
+ */
+void bench_register(const char* name, bench_fn_t fn, void* arg, unsigned int iters) {
+    if (num_benches == BENCH_MAX) {
+        return;
+    }
+    benches[num_benches].name = name;
+    benches[num_benches].fn = fn;
+    benches[num_benches].arg = arg;
+    benches[num_benches].iters = iters;
+    num_benches++;
+}
+
+/*
+ * Returns cycles per one call of 'b->fn' for one repetition.
+ */
+static unsigned int bench_once(struct bench* b) {
+    unsigned long long start, end, cycles;
+    start = rdtsc_serialized();
+    for (unsigned int i = 0; i < b->iters; i++) {
+        b->fn(b->arg);
+    }
+    end = rdtsc_serialized();
+    /* overhead is timed once per repetition, not once per call */
+    cycles = end - start > overhead ? end - start - overhead : 0;
+    return (unsigned int)udiv64(cycles, b->iters, 0);
+}
+
+static void bench_run(struct bench* b) {
+    unsigned int deviations[BENCH_REPS];
+    unsigned int median, mad, min = 0, max = 0, kept = 0;
+    unsigned long long sum = 0;
+
+    for (int i = 0; i < BENCH_WARMUP; i++) {
+        bench_once(b);
+    }
+    for (int i = 0; i < BENCH_REPS; i++) {
+        samples[i] = bench_once(b);
+    }
+    serial_printf("SAMPLES name=%s", b->name);
+    for (int i = 0; i < BENCH_REPS; i++) {
+        serial_printf(" %u", samples[i]);
+    }
+    serial_printf("\n");
+
+    /* reject outliers by median absolute deviation */
+    sort_uint(samples, BENCH_REPS);
+    median = samples[BENCH_REPS / 2];
+    for (int i = 0; i < BENCH_REPS; i++) {
+        deviations[i] = samples[i] > median ? samples[i] - median : median - samples[i];
+    }
+    sort_uint(deviations, BENCH_REPS);
+    mad = deviations[BENCH_REPS / 2];
+    if (mad == 0) {
+        mad = 1;
+    }
+    for (int i = 0; i < BENCH_REPS; i++) {
+        unsigned int d = samples[i] > median ? samples[i] - median : median - samples[i];
+        if (d > 3 * mad) {
+            continue;
+        }
+        if (kept == 0) {
+            min = samples[i];
+        }
+        max = samples[i];
+        sum += samples[i];
+        kept++;
+    }
+    serial_printf("BENCH name=%s iters=%u kept=%u min=%u median=%u mean=%u max=%u unit=cycles\n",
+                  b->name, b->iters, kept, min, median,
+                  (unsigned int)udiv64(sum, kept, 0), max);
+}
+
+static void bench_nothing(void* arg) {
+}
+
+/*
+ * Runs all registered benchmarks and prints results to serial port.
+ */
+void bench_run_all() {
+    struct bench empty = { "overhead", bench_nothing, NULL, 1 };
+    /* timing overhead is the fastest empty measurement */
+    overhead = 0;
+    unsigned int o = bench_once(&empty);
+    for (int i = 0; i < BENCH_REPS; i++) {
+        unsigned int c = bench_once(&empty);
+        if (c < o) {
+            o = c;
+        }
+    }
+    overhead = o;
+    serial_printf("BENCH_START tsc_khz=%u reps=%u warmup=%u overhead=%u\n",
+                  tsc_khz, BENCH_REPS, BENCH_WARMUP, overhead);
+    for (int i = 0; i < num_benches; i++) {
+        bench_run(&benches[i]);
+    }
+    serial_printf("BENCH_DONE count=%u dropped=%u\n", num_benches, serial_dropped);
+    serial_flush();
+}
+
+/* common library benchmarks */
+
+static void bench_malloc_free(void* arg) {
+    free(malloc((size_t)arg));
+}
+
+static void bench_printf(void* arg) {
+    move_cursor(1, 1);
+    printf("Score: %d", 12345);
+}
+
+static void bench_snprintf(void* arg) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "Score: %d next %x %s", 12345, 0xbeef, "brick");
+}
+
+/* format in .data, so printf parses it on every call */
+static char uncached_format[] = "Score: %d next %x %s";
+
+static void bench_snprintf_uncached(void* arg) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), uncached_format, 12345, 0xbeef, "brick");
+}
+
+static void bench_format_u32(void* arg) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%u %u %u %u", 7u, 65535u, 1234567u, 4294967295u);
+}
+
+static void bench_format_u64(void* arg) {
+    char buf[96];
+    snprintf(buf, sizeof(buf), "%llu %llu", 123456789012ULL, 18446744073709551615ULL);
+}
+
+static void bench_format_hex(void* arg) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%x %llx %o", 0xdeadbeefu, 0x123456789abcdefULL, 0777u);
+}
+
+static void bench_log_event(void* arg) {
+    log_event("Score: %d next %x %s\n", 12345, 0xbeef, "brick");
+}
+
+static void bench_log_printf(void* arg) {
+    log_printf("Score: %d next %x %s\n", 12345, 0xbeef, "brick");
+}
+
+static void bench_puts(void* arg) {
+    move_cursor(1, 1);
+    puts("Arrows: move, Enter: rotate, Esc: pause");
+}
+
+static void bench_clear_screen(void* arg) {
+    clear_screen();
+}
+
+/*
+ * Registers benchmarks of common library functions.
+ */
+void bench_init() {
+    bench_register("malloc_free_16", bench_malloc_free, (void*)16, 64);
+    bench_register("malloc_free_1k", bench_malloc_free, (void*)1024, 64);
+    bench_register("printf_score", bench_printf, NULL, 64);
+    bench_register("snprintf", bench_snprintf, NULL, 64);
+    bench_register("snprintf_uncached", bench_snprintf_uncached, NULL, 64);
+    bench_register("format_u32", bench_format_u32, NULL, 64);
+    bench_register("format_u64", bench_format_u64, NULL, 64);
+    bench_register("format_hex", bench_format_hex, NULL, 64);
+    bench_register("log_event", bench_log_event, NULL, 64);
+    bench_register("log_printf", bench_log_printf, NULL, 64);
+    bench_register("puts_line", bench_puts, NULL, 64);
+    bench_register("clear_screen", bench_clear_screen, NULL, 4);
+    printf_bench_register();
+    string_bench_register();
+    fb_bench_register();
+}
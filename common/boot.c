@@ -0,0 +1,48 @@
+/*
+ * Contains boot phase timestamps and startup latency report.
+ * Time is counted from entry to 'loader', each mark records
+ * the end of a phase.
+ */
+
+#include "boot.h"
+#include "serial.h"
+#include "time.h"
+
+struct boot_phase {
+    const char* name;
+    unsigned long long tsc;
+};
+
+static struct boot_phase phases[BOOT_MAX_PHASES];
+static int num_phases = 0;
+
+/*
+ * Records that boot 'phase' has just completed.
+ * 'phase' must be a string literal.
+ */
+void boot_mark(const char* phase) {
+    if (num_phases == BOOT_MAX_PHASES) {
+        return;
+    }
+    phases[num_phases].name = phase;
+    phases[num_phases].tsc = rdtsc();
+    num_phases++;
+}
+
+/*
+ * Prints time of every phase in microseconds to serial port:
+ *   BOOT phase=<name> at=<us since loader> took=<us>
+ *   BOOT_TOTAL us=<us>
+ * Needs tsc_calibrate to be done.
+ */
+void boot_report() {
+    unsigned long long prev = boot_tsc;
+    for (int i = 0; i < num_phases; i++) {
+        serial_printf("BOOT phase=%s at=%llu took=%llu\n", phases[i].name,
+                      tsc_to_us(phases[i].tsc - boot_tsc),
+                      tsc_to_us(phases[i].tsc - prev));
+        prev = phases[i].tsc;
+    }
+    serial_printf("BOOT_TOTAL us=%llu\n", tsc_to_us(prev - boot_tsc));
+    serial_flush();
+}
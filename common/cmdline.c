@@ -0,0 +1,84 @@
+/*
+ * Contains access to kernel command line passed by bootloader.
+ * Options are words separated by spaces, either 'name' or 'key=value'.
+ */
+
+#include "cmdline.h"
+
+static const char* cmdline = "";
+
+/*
+ * Remembers command line from Multiboot struct 'mbd' if GRUB passed it.
+ */
+void cmdline_init(multiboot_info_t* mbd) {
+    if (mbd->flags & (1 << 2)) {
+        cmdline = (const char*)mbd->cmdline;
+    }
+}
+
+/*
+ * Returns pointer to the first char after 'word' if command line has
+ * option named 'word', else NULL.
+ */
+static const char* find_word(const char* word) {
+    const char* s = cmdline;
+    while (*s != '\0') {
+        const char* w = word;
+        const char* p = s;
+        while (*w != '\0' && *p == *w) {
+            p++;
+            w++;
+        }
+        if (*w == '\0' && (*p == ' ' || *p == '\0' || *p == '=')) {
+            return p;
+        }
+        while (*s != '\0' && *s != ' ') {
+            s++;
+        }
+        while (*s == ' ') {
+            s++;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Checks if command line contains word 'option'.
+ */
+int cmdline_has(const char* option) {
+    const char* p = find_word(option);
+    return p != NULL && *p != '=';
+}
+
+/*
+ * Copies value of 'key=value' option into 'buf' of 'size' bytes.
+ * Returns 'buf' or NULL if there is no such option.
+ */
+const char* cmdline_value(const char* key, char* buf, size_t size) {
+    const char* p = find_word(key);
+    size_t i = 0;
+    if (p == NULL || *p != '=' || size == 0) {
+        return NULL;
+    }
+    p++;
+    while (i + 1 < size && *p != ' ' && *p != '\0') {
+        buf[i++] = *p++;
+    }
+    buf[i] = '\0';
+    return buf;
+}
+
+/*
+ * Returns decimal value of 'key=value' option or 'def' if there is none.
+ */
+int cmdline_int(const char* key, int def) {
+    char buf[12];
+    int r = 0;
+    if (cmdline_value(key, buf, sizeof(buf)) == NULL || buf[0] < '0' || buf[0] > '9') {
+        return def;
+    }
+    for (char* p = buf; *p >= '0' && *p <= '9'; p++) {
+        r = r * 10 + (*p - '0');
+    }
+    return r;
+}
@@ -4,12 +4,24 @@
 
 #include "cursor.h"
 
+/* cursor position last written to CRTC, -1 if unknown */
+static int hw_pos = -1;
+/* if set, CRTC is updated only by cursor_sync */
+static char cursor_deferred = 0;
+/* hidden cursor position is never written to CRTC */
+static char cursor_enabled = 1;
+/* text memory cell shown at top left corner of screen */
+static int origin = 0;
+
 void disable_cursor() {
     outb(0x0A, 0x3D4);
     outb(0x20, 0x3D5);
+    cursor_enabled = 0;
 }
 
 void enable_cursor(unsigned short int cursor_start, unsigned short int cursor_end) {
+    cursor_enabled = 1;
+    cursor_sync();
     outb(0x0A, 0x3D4);
     outb((inb(0x3D5) & 0xC0) | cursor_start, 0x3D5);
  
@@ -17,23 +29,62 @@ void enable_cursor(unsigned short int cursor_start, unsigned short int cursor_en
     outb((inb(0x3E0) & 0xE0) | cursor_end, 0x3D5);
 }
 
-void move_cursor(int x, int y) {
-    int pos = VGA_WIDTH * y + x;
+/*
+ * Writes cursor position to CRTC if cursor is visible and
+ * position differs from the last one written.
+ */
+void cursor_sync() {
+    int pos = origin + VGA_WIDTH * shown_console->y + shown_console->x;
+    if (! cursor_enabled || pos == hw_pos) {
+        return;
+    }
     outb(0x0F, 0x3D4);
     outb((unsigned char) (pos & 0xFF), 0x3D5);
     outb(0x0E, 0x3D4);
     outb((unsigned char) ((pos >> 8) & 0xFF), 0x3D5);
-    cursor_x = x;
-    cursor_y = y;
+    hw_pos = pos;
+}
+
+/*
+ * Tells where the screen starts in text memory after scrolling.
+ */
+void cursor_set_origin(int cell) {
+    origin = cell;
+    if (! cursor_deferred) {
+        cursor_sync();
+    }
+}
+
+/*
+ * While 'deferred' is set, cursor moves only change console cursor position,
+ * and hardware cursor follows it on cursor_sync.
+ */
+void cursor_defer(int deferred) {
+    cursor_deferred = deferred;
+    if (! deferred) {
+        cursor_sync();
+    }
+}
+
+/*
+ * Moves cursor of the current console. Hardware cursor follows
+ * only the shown console.
+ */
+void move_cursor(int x, int y) {
+    cur_console->x = x;
+    cur_console->y = y;
+    if (! cursor_deferred && cur_console == shown_console) {
+        cursor_sync();
+    }
 }
 
 void move_cursor_delta(int delta_x, int delta_y) {
-    int x = cursor_x + delta_x;
-    int y = cursor_y + delta_y;
+    int x = cur_console->x + delta_x;
+    int y = cur_console->y + delta_y;
     if ((x >= VGA_WIDTH) || (x < 0) || (y >= VGA_HEIGHT) || (y < 0)) return;
     move_cursor(x, y);
 }
 
 void update_cursor() {
-    move_cursor(cursor_x, cursor_y);
+    move_cursor(cur_console->x, cur_console->y);
 }
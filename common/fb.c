@@ -0,0 +1,340 @@
+/*
+ * Contains linear framebuffer graphics functions.
+ *
+ * Drawing goes to a back buffer in RAM and marks dirty rectangles.
+ * fb_present copies only those to the framebuffer, whose memory is
+ * slow to write. Only 32 bits per pixel modes are supported.
+ *
+ * Text console cells are drawn with the kernel's own 8x8 font,
+ * scaled to fill as much of the screen as integer factors allow.
+ */
+
+#include "fb.h"
+#include "bench.h"
+#include "font.h"
+#include "fpu.h"
+#include "memory.h"
+#include "string.h"
+#include "sys.h"
+
+#define GLYPH_SIZE    FONT_HEIGHT
+#define TEXT_COLS     VGA_WIDTH
+#define TEXT_ROWS     VGA_HEIGHT
+#define SCALE_MAX     8
+
+/* rectangle of pixels, x1 and y1 are exclusive */
+struct rect {
+    int x0, y0, x1, y1;
+};
+
+int fb_active = 0;
+unsigned int fb_width = 0, fb_height = 0;
+
+static unsigned int* front;     /* framebuffer */
+static unsigned int* back;      /* back buffer, 'fb_width' pixels per row */
+static unsigned int front_pitch;    /* bytes per framebuffer row */
+static unsigned char red_pos, green_pos, blue_pos;
+
+static struct rect dirty[FB_DIRTY_MAX];
+static int num_dirty = 0;
+
+/* text console geometry */
+static int scale_x, scale_y;
+static int text_x, text_y;      /* top left corner of text area */
+static unsigned int palette[16];
+
+/* VGA text colors */
+static const unsigned char vga_rgb[16][3] = {
+    {0x00, 0x00, 0x00}, {0x00, 0x00, 0xAA}, {0x00, 0xAA, 0x00}, {0x00, 0xAA, 0xAA},
+    {0xAA, 0x00, 0x00}, {0xAA, 0x00, 0xAA}, {0xAA, 0x55, 0x00}, {0xAA, 0xAA, 0xAA},
+    {0x55, 0x55, 0x55}, {0x55, 0x55, 0xFF}, {0x55, 0xFF, 0x55}, {0x55, 0xFF, 0xFF},
+    {0xFF, 0x55, 0x55}, {0xFF, 0x55, 0xFF}, {0xFF, 0xFF, 0x55}, {0xFF, 0xFF, 0xFF},
+};
+
+unsigned int fb_rgb(unsigned char r, unsigned char g, unsigned char b) {
+    return (unsigned int)r << red_pos | (unsigned int)g << green_pos | (unsigned int)b << blue_pos;
+}
+
+/*
+ * Adds rectangle to dirty list. It is merged into a touching one if there is
+ * such; when the list is full, everything is merged into a single rectangle.
+ */
+static void fb_dirty(int x0, int y0, int x1, int y1) {
+    struct rect* d = NULL;
+    for (int i = 0; i < num_dirty; i++) {
+        d = &dirty[i];
+        if (d->x0 <= x1 && x0 <= d->x1 && d->y0 <= y1 && y0 <= d->y1) {
+            break;
+        }
+        d = NULL;
+    }
+    if (d == NULL) {
+        if (num_dirty < FB_DIRTY_MAX) {
+            d = &dirty[num_dirty++];
+            d->x0 = x0;
+            d->y0 = y0;
+            d->x1 = x1;
+            d->y1 = y1;
+            return;
+        }
+        d = &dirty[0];
+        for (int i = 1; i < num_dirty; i++) {
+            if (dirty[i].x0 < d->x0) d->x0 = dirty[i].x0;
+            if (dirty[i].y0 < d->y0) d->y0 = dirty[i].y0;
+            if (dirty[i].x1 > d->x1) d->x1 = dirty[i].x1;
+            if (dirty[i].y1 > d->y1) d->y1 = dirty[i].y1;
+        }
+        num_dirty = 1;
+    }
+    if (x0 < d->x0) d->x0 = x0;
+    if (y0 < d->y0) d->y0 = y0;
+    if (x1 > d->x1) d->x1 = x1;
+    if (y1 > d->y1) d->y1 = y1;
+}
+
+/*
+ * Fills 'n' pixels, 64 bytes per iteration with SSE2 when it is enabled.
+ */
+static void fill_row(unsigned int* p, unsigned int color, int n) {
+    if (fpu_sse && n >= 32) {
+        int blocks;
+        while ((unsigned int)p & 15) {
+            *p++ = color;
+            n--;
+        }
+        blocks = n >> 4;
+        __asm__ volatile (
+            "movd %2, %%xmm0\n"
+            "pshufd $0, %%xmm0, %%xmm0\n"
+            "1:\n"
+            "movdqa %%xmm0, (%0)\n"
+            "movdqa %%xmm0, 16(%0)\n"
+            "movdqa %%xmm0, 32(%0)\n"
+            "movdqa %%xmm0, 48(%0)\n"
+            "addl $64, %0\n"
+            "decl %1\n"
+            "jnz 1b\n"
+            : "+r"(p), "+r"(blocks)
+            : "r"(color)
+            : "memory", "xmm0"
+        );
+        n &= 15;
+    }
+    __asm__ volatile ("rep stosl" : "+D"(p), "+c"(n) : "a"(color) : "memory");
+}
+
+/*
+ * Clips rectangle to screen, returns 0 if nothing is left of it.
+ */
+static int clip(int* x, int* y, int* w, int* h) {
+    if (*x < 0) {
+        *w += *x;
+        *x = 0;
+    }
+    if (*y < 0) {
+        *h += *y;
+        *y = 0;
+    }
+    if (*x + *w > (int)fb_width) {
+        *w = fb_width - *x;
+    }
+    if (*y + *h > (int)fb_height) {
+        *h = fb_height - *y;
+    }
+    return *w > 0 && *h > 0;
+}
+
+void fb_fill_rect(int x, int y, int w, int h, unsigned int color) {
+    if (! clip(&x, &y, &w, &h)) {
+        return;
+    }
+    for (int i = 0; i < h; i++) {
+        fill_row(&back[(y + i) * fb_width + x], color, w);
+    }
+    fb_dirty(x, y, x + w, y + h);
+}
+
+/*
+ * Copies 'w' x 'h' pixels from 'src' having 'src_pitch' pixels per row.
+ */
+void fb_blit(int x, int y, int w, int h, const unsigned int* src, int src_pitch) {
+    int x0 = x, y0 = y;
+    if (! clip(&x, &y, &w, &h)) {
+        return;
+    }
+    src += (y - y0) * src_pitch + (x - x0);
+    for (int i = 0; i < h; i++) {
+        memcpy(&back[(y + i) * fb_width + x], &src[i * src_pitch], w * sizeof(*src));
+    }
+    fb_dirty(x, y, x + w, y + h);
+}
+
+/*
+ * Draws glyph of 'c' scaled by text console factors, top left at 'x', 'y'.
+ * Doesn't mark anything dirty.
+ */
+static void draw_glyph(int x, int y, unsigned char c, unsigned int fg, unsigned int bg) {
+    const unsigned char* glyph = font8x8[c < FONT_CHARS ? c : '?'];
+    unsigned int line[GLYPH_SIZE * SCALE_MAX];
+    int width = GLYPH_SIZE * scale_x;
+    unsigned int* dst = &back[y * fb_width + x];
+    for (int row = 0; row < GLYPH_SIZE; row++) {
+        unsigned char bits = glyph[row];
+        unsigned int* p = line;
+        for (int bit = 0x80; bit != 0; bit >>= 1) {
+            unsigned int color = (bits & bit) ? fg : bg;
+            for (int i = 0; i < scale_x; i++) {
+                *p++ = color;
+            }
+        }
+        for (int i = 0; i < scale_y; i++) {
+            memcpy(dst, line, width * sizeof(*line));
+            dst += fb_width;
+        }
+    }
+}
+
+void fb_draw_char(int x, int y, unsigned char c, unsigned int fg, unsigned int bg) {
+    int w = GLYPH_SIZE * scale_x, h = GLYPH_SIZE * scale_y;
+    if (x < 0 || y < 0 || x + w > (int)fb_width || y + h > (int)fb_height) {
+        return;
+    }
+    draw_glyph(x, y, c, fg, bg);
+    fb_dirty(x, y, x + w, y + h);
+}
+
+/*
+ * Draws 'count' text console cells from 'src', first of them being 'cell'.
+ */
+void fb_text_cells(int cell, int count, const unsigned short* src) {
+    int w = GLYPH_SIZE * scale_x, h = GLYPH_SIZE * scale_y;
+    while (count > 0) {
+        int row = cell / TEXT_COLS, col = cell % TEXT_COLS;
+        int run = TEXT_COLS - col < count ? TEXT_COLS - col : count;
+        int x = text_x + col * w, y = text_y + row * h;
+        for (int i = 0; i < run; i++) {
+            unsigned short v = src[i];
+            draw_glyph(x + i * w, y, v & 0xFF, palette[(v >> 8) & 0xF], palette[v >> 12]);
+        }
+        fb_dirty(x, y, x + run * w, y + h);
+        cell += run;
+        count -= run;
+        src += run;
+    }
+}
+
+/*
+ * Copies dirty rectangles of back buffer to framebuffer.
+ */
+void fb_present() {
+    for (int i = 0; i < num_dirty; i++) {
+        struct rect* d = &dirty[i];
+        size_t bytes = (d->x1 - d->x0) * sizeof(*back);
+        for (int y = d->y0; y < d->y1; y++) {
+            memcpy((char*)front + y * front_pitch + d->x0 * sizeof(*back),
+                   &back[y * fb_width + d->x0], bytes);
+        }
+    }
+    num_dirty = 0;
+}
+
+/*
+ * Sets up drawing to 'width' x 'height' pixels at 'fb', returns 0 on failure.
+ */
+static int fb_setup(unsigned int* fb, unsigned int width, unsigned int height, unsigned int pitch) {
+    if (width < TEXT_COLS * GLYPH_SIZE || height < TEXT_ROWS * GLYPH_SIZE) {
+        return 0;
+    }
+    back = malloc(width * height * sizeof(*back));
+    if (back == NULL) {
+        return 0;
+    }
+    front = fb;
+    front_pitch = pitch;
+    fb_width = width;
+    fb_height = height;
+
+    /* square-ish cells like in VGA text mode, which are twice as high */
+    scale_x = width / (TEXT_COLS * GLYPH_SIZE);
+    scale_y = height / (TEXT_ROWS * GLYPH_SIZE);
+    if (scale_x > SCALE_MAX) {
+        scale_x = SCALE_MAX;
+    }
+    if (scale_y > 2 * scale_x) {
+        scale_y = 2 * scale_x;
+    }
+    text_x = (width - TEXT_COLS * GLYPH_SIZE * scale_x) / 2;
+    text_y = (height - TEXT_ROWS * GLYPH_SIZE * scale_y) / 2;
+    for (int i = 0; i < 16; i++) {
+        palette[i] = fb_rgb(vga_rgb[i][0], vga_rgb[i][1], vga_rgb[i][2]);
+    }
+    num_dirty = 0;
+    fb_fill_rect(0, 0, width, height, palette[0]);
+    return 1;
+}
+
+/*
+ * Uses framebuffer set up by boot loader, if it is 32 bits per pixel RGB.
+ * Returns 1 if text console is drawn to it from now on.
+ */
+int fb_init(multiboot_info_t* mbd) {
+    if (! (mbd->flags & MULTIBOOT_INFO_FRAMEBUFFER) ||
+            mbd->framebuffer_type != MULTIBOOT_FRAMEBUFFER_TYPE_RGB ||
+            mbd->framebuffer_bpp != 32 || mbd->framebuffer_addr >> 32) {
+        return 0;
+    }
+    red_pos = mbd->framebuffer_red_field_position;
+    green_pos = mbd->framebuffer_green_field_position;
+    blue_pos = mbd->framebuffer_blue_field_position;
+    fb_active = fb_setup((unsigned int*)(unsigned int)mbd->framebuffer_addr,
+                         mbd->framebuffer_width, mbd->framebuffer_height,
+                         mbd->framebuffer_pitch);
+    if (fb_active) {
+        fb_present();
+    }
+    return fb_active;
+}
+
+/* graphics benchmarks */
+
+#define BENCH_WIDTH   1024
+#define BENCH_HEIGHT  768
+
+static unsigned short bench_cells[TEXT_COLS * TEXT_ROWS];
+
+static void bench_fill(void* arg) {
+    fb_fill_rect(0, 0, fb_width, fb_height, fb_rgb(0x20, 0x40, 0x80));
+    num_dirty = 0;
+}
+
+static void bench_present(void* arg) {
+    fb_dirty(0, 0, fb_width, fb_height);
+    fb_present();
+}
+
+static void bench_text(void* arg) {
+    fb_text_cells(0, TEXT_COLS * TEXT_ROWS, bench_cells);
+    num_dirty = 0;
+}
+
+/*
+ * Registers framebuffer benchmarks. Without a framebuffer they draw to
+ * BENCH_WIDTH x BENCH_HEIGHT pixels of RAM, so they also run headless.
+ */
+void fb_bench_register() {
+    if (! fb_active) {
+        unsigned int* ram = malloc(BENCH_WIDTH * BENCH_HEIGHT * sizeof(*ram));
+        red_pos = 16;
+        green_pos = 8;
+        blue_pos = 0;
+        if (ram == NULL || ! fb_setup(ram, BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH * sizeof(*ram))) {
+            return;
+        }
+    }
+    for (int i = 0; i < TEXT_COLS * TEXT_ROWS; i++) {
+        bench_cells[i] = 0x0700 | ('A' + i % 26);
+    }
+    bench_register("fb_fill_full", bench_fill, NULL, 4);
+    bench_register("fb_present_full", bench_present, NULL, 4);
+    bench_register("fb_text_full", bench_text, NULL, 4);
+}
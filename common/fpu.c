@@ -0,0 +1,138 @@
+/*
+ * Contains FPU/SSE initialization and lazy FPU context switching.
+ *
+ * FPU registers belong to one context at a time, the owner. Switching to
+ * another context only sets CR0.TS; the first FPU or SSE instruction then
+ * raises #NM, and its handler saves the owner's registers and loads the
+ * new context's ones. Contexts that never touch the FPU pay nothing.
+ */
+
+#include "fpu.h"
+#include "interrupts.h"
+
+#define MXCSR_DEFAULT  0x1F80       /* all SIMD exceptions masked */
+
+int fpu_sse = 0;
+unsigned int fpu_restores = 0;
+
+static int fpu_fxsr = 0;
+static struct fpu_ctx kernel_ctx;
+static struct fpu_ctx* fpu_current = &kernel_ctx;  /* context running now */
+static struct fpu_ctx* fpu_owner = &kernel_ctx;    /* context in FPU registers */
+
+static inline unsigned int read_cr0() {
+    unsigned int cr0;
+    __asm__ volatile ("movl %%cr0, %0" : "=r"(cr0));
+    return cr0;
+}
+
+static inline void write_cr0(unsigned int cr0) {
+    __asm__ volatile ("movl %0, %%cr0" : : "r"(cr0) : "memory");
+}
+
+static inline unsigned int read_cr4() {
+    unsigned int cr4;
+    __asm__ volatile ("movl %%cr4, %0" : "=r"(cr4));
+    return cr4;
+}
+
+static inline void write_cr4(unsigned int cr4) {
+    __asm__ volatile ("movl %0, %%cr4" : : "r"(cr4) : "memory");
+}
+
+static inline void clts() {
+    __asm__ volatile ("clts" : : : "memory");
+}
+
+/*
+ * Puts FPU and SSE registers to their power-on state.
+ */
+static void fpu_reset() {
+    unsigned int mxcsr = MXCSR_DEFAULT;
+    __asm__ volatile ("fninit");
+    if (fpu_sse) {
+        __asm__ volatile ("ldmxcsr %0" : : "m"(mxcsr));
+    }
+}
+
+static void fpu_save(struct fpu_ctx* ctx) {
+    if (fpu_fxsr) {
+        __asm__ volatile ("fxsave %0" : "=m"(ctx->area));
+    } else {
+        __asm__ volatile ("fnsave %0" : "=m"(ctx->area));
+    }
+}
+
+static void fpu_restore(struct fpu_ctx* ctx) {
+    if (fpu_fxsr) {
+        __asm__ volatile ("fxrstor %0" : : "m"(ctx->area));
+    } else {
+        __asm__ volatile ("frstor %0" : : "m"(ctx->area));
+    }
+}
+
+/*
+ * Device not available: the running context wants FPU registers
+ * which may hold another context's state.
+ */
+static void fpu_nm_handler(struct regs* r) {
+    clts();
+    if (fpu_owner == fpu_current) {
+        return;
+    }
+    if (fpu_owner != NULL) {
+        fpu_save(fpu_owner);
+    }
+    if (fpu_current->used) {
+        fpu_restore(fpu_current);
+    } else {
+        fpu_reset();
+        fpu_current->used = 1;
+    }
+    fpu_owner = fpu_current;
+    fpu_restores++;
+}
+
+/*
+ * Enables FPU and, when CPU supports it, SSE with fxsave/fxrstor.
+ * Kernel context owns FPU registers afterwards.
+ */
+void fpu_init() {
+    unsigned int a, b, c, d;
+    __asm__ volatile ("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(1));
+    if (! (d & CPUID_EDX_FPU)) {
+        return;
+    }
+    write_cr0((read_cr0() | CR0_MP | CR0_NE) & ~(CR0_EM | CR0_TS));
+    if ((d & CPUID_EDX_FXSR) && (d & CPUID_EDX_SSE)) {
+        write_cr4(read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT);
+        fpu_fxsr = 1;
+        fpu_sse = 1;
+    }
+    fpu_reset();
+    kernel_ctx.used = 1;
+    isr_install(VECTOR_NM, fpu_nm_handler);
+}
+
+/*
+ * Prepares 'ctx' for its first use; its registers start in reset state.
+ */
+void fpu_ctx_init(struct fpu_ctx* ctx) {
+    ctx->used = 0;
+}
+
+/*
+ * Makes 'next' the running context. Registers are switched lazily,
+ * on the first FPU instruction of 'next'.
+ */
+void fpu_switch(struct fpu_ctx* next) {
+    if (next == NULL) {
+        next = &kernel_ctx;
+    }
+    fpu_current = next;
+    if (next == fpu_owner) {
+        clts();
+    } else {
+        write_cr0(read_cr0() | CR0_TS);
+    }
+}
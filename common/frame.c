@@ -0,0 +1,144 @@
+/*
+ * Contains frame pacing and frame time statistics.
+ *
+ * frame_wait returns at the start of the next frame, after which the
+ * caller draws and presents it. If VGA signals vertical retrace, frames
+ * start at retrace, so presenting never tears and never runs faster than
+ * the display; the frame period is rounded to whole refresh periods.
+ * Otherwise frames start at time stamp counter deadlines.
+ * Keyboard is polled while waiting.
+ */
+
+#include "frame.h"
+#include "keyboard.h"
+#include "log.h"
+#include "serial.h"
+#include "time.h"
+
+#define RETRACE_TIMEOUT_MS  100     /* no retrace in this time means no VGA */
+
+struct frame_stats frame_stats;
+
+static int vretrace = 0;            /* whether retrace is used */
+static unsigned long long period;   /* frame period in cycles */
+static unsigned long long refresh;  /* display refresh period in cycles */
+static unsigned long long deadline; /* start of next frame */
+static unsigned long long last;     /* start of current frame */
+static int skip = 0;                /* whether next frame isn't measured */
+
+static inline unsigned long long ms_to_tsc(unsigned int ms) {
+    return (unsigned long long)tsc_khz * ms;
+}
+
+/*
+ * Waits for vertical retrace to begin, returns 0 on timeout.
+ */
+static int retrace_edge(unsigned long long timeout) {
+    unsigned long long end = rdtsc() + timeout;
+    while (inb(VGA_STATUS) & VGA_VRETRACE) {
+        if (rdtsc() > end) {
+            return 0;
+        }
+    }
+    while (! (inb(VGA_STATUS) & VGA_VRETRACE)) {
+        if (rdtsc() > end) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Sets target frame rate to 'fps' and measures display refresh period.
+ */
+void frame_init(unsigned int fps) {
+    unsigned long long start;
+    if (fps == 0) {
+        fps = FRAME_FPS;
+    }
+    period = udiv64(ms_to_tsc(1000), fps, 0);
+    vretrace = 0;
+    if (retrace_edge(ms_to_tsc(RETRACE_TIMEOUT_MS))) {
+        start = rdtsc();
+        if (retrace_edge(ms_to_tsc(RETRACE_TIMEOUT_MS))) {
+            refresh = rdtsc() - start;
+            /* 20 to 200 Hz */
+            vretrace = refresh > ms_to_tsc(5) && refresh < ms_to_tsc(50);
+        }
+    }
+    frame_stats.frames = frame_stats.missed = 0;
+    frame_stats.min = frame_stats.max = frame_stats.sum = 0;
+    frame_resync();
+}
+
+/*
+ * Waits for the start of the next frame and records time of the current one.
+ * Returns that time in cycles, 0 if it isn't measured.
+ */
+unsigned long long frame_wait() {
+    unsigned long long now, took;
+    if (vretrace) {
+        /* retrace after deadline; aim half a refresh early so it isn't missed */
+        while (rdtsc() + refresh / 2 < deadline) {
+            key_poll();
+        }
+        if (! retrace_edge(2 * refresh)) {
+            vretrace = 0;
+        }
+    } else {
+        while (rdtsc() < deadline) {
+            key_poll();
+        }
+    }
+    now = rdtsc();
+    took = now - last;
+    last = now;
+    if (vretrace || now > deadline + period) {
+        /* late timer frames don't try to catch up */
+        deadline = now + period;
+    } else {
+        deadline += period;
+    }
+    if (skip) {
+        skip = 0;
+        return 0;
+    }
+    if (frame_stats.frames == 0 || took < frame_stats.min) {
+        frame_stats.min = took;
+    }
+    if (took > frame_stats.max) {
+        frame_stats.max = took;
+    }
+    if (2 * took > 3 * period) {
+        frame_stats.missed++;
+        log_event("frame %u missed, %llu cycles\n", frame_stats.frames, took);
+    }
+    frame_stats.sum += took;
+    frame_stats.frames++;
+    return took;
+}
+
+/*
+ * Starts frame timing anew, e.g. after waiting for a key in a menu.
+ * Time until the next frame_wait isn't recorded.
+ */
+void frame_resync() {
+    last = deadline = rdtsc();
+    skip = 1;
+}
+
+/*
+ * Prints frame time statistics in microseconds to serial port:
+ *   FRAME frames=<n> missed=<n> target_us=<us> refresh_us=<us> min_us=<us> mean_us=<us> max_us=<us>
+ * refresh_us is 0 when frames are paced by timer.
+ */
+void frame_report() {
+    unsigned long long mean = 0;
+    if (frame_stats.frames > 0) {
+        mean = udiv64(frame_stats.sum, frame_stats.frames, 0);
+    }
+    serial_printf("FRAME frames=%u missed=%u target_us=%llu refresh_us=%llu min_us=%llu mean_us=%llu max_us=%llu\n",
+                  frame_stats.frames, frame_stats.missed, tsc_to_us(period),
+                  vretrace ? tsc_to_us(refresh) : 0ULL, tsc_to_us(frame_stats.min),
+                  tsc_to_us(mean), tsc_to_us(frame_stats.max));
+}
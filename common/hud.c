@@ -0,0 +1,156 @@
+/*
+ * Contains frame time and input latency overlay drawn over the game.
+ *
+ * Measurements are only stored per frame. Statistics are computed and
+ * drawn every HUD_REFRESH frames, by hud_draw, which the game calls
+ * outside of measured spans.
+ */
+
+#include "hud.h"
+#include "printf.h"
+#include "screen.h"
+#include "sys.h"
+#include "time.h"
+
+#define HUD_X      1        /* left column of overlay */
+#define HUD_Y      3        /* top row of overlay, below score */
+#define HUD_WIDTH  32       /* chars left of game field */
+
+int hud_enabled = 0;
+
+static unsigned int frame_us[HUD_WINDOW];   /* latest frame times */
+static int num_frames = 0, next_frame = 0;
+static unsigned long long span_sum[HUD_SPANS];
+static unsigned int span_count[HUD_SPANS];
+static unsigned int latency_us[HUD_LATENCIES];  /* newest first */
+static int num_latencies = 0;
+static int frames_to_draw = 0;
+
+static const char* span_names[HUD_SPANS] = {
+    "key_work",
+    "game_update",
+    "video_update",
+};
+
+void hud_init(int enabled) {
+    hud_enabled = enabled;
+    num_frames = next_frame = num_latencies = frames_to_draw = 0;
+    for (int i = 0; i < HUD_SPANS; i++) {
+        span_sum[i] = 0;
+        span_count[i] = 0;
+    }
+}
+
+/*
+ * Records time of the last frame, 0 if it wasn't measured.
+ */
+void hud_frame(unsigned long long cycles) {
+    if (! hud_enabled || cycles == 0) {
+        return;
+    }
+    frame_us[next_frame] = (unsigned int)tsc_to_us(cycles);
+    next_frame = (next_frame + 1) % HUD_WINDOW;
+    if (num_frames < HUD_WINDOW) {
+        num_frames++;
+    }
+}
+
+/*
+ * Records time spent in 'span' during this frame.
+ */
+void hud_span(int span, unsigned long long cycles) {
+    if (! hud_enabled) {
+        return;
+    }
+    span_sum[span] += cycles;
+    span_count[span]++;
+}
+
+/*
+ * Records time from key press scancode to the frame showing its effect.
+ */
+void hud_latency(unsigned long long cycles) {
+    if (! hud_enabled) {
+        return;
+    }
+    for (int i = HUD_LATENCIES - 1; i > 0; i--) {
+        latency_us[i] = latency_us[i - 1];
+    }
+    latency_us[0] = (unsigned int)tsc_to_us(cycles);
+    if (num_latencies < HUD_LATENCIES) {
+        num_latencies++;
+    }
+}
+
+/*
+ * Writes 'line' at overlay row 'row', padded to overlay width.
+ */
+static void hud_line(int row, const char* line) {
+    char buf[HUD_WIDTH + 1];
+    int i = 0;
+    for (; i < HUD_WIDTH && line[i] != '\0'; i++) {
+        buf[i] = line[i];
+    }
+    for (; i < HUD_WIDTH; i++) {
+        buf[i] = ' ';
+    }
+    buf[HUD_WIDTH] = '\0';
+    move_cursor(HUD_X, HUD_Y + row);
+    puts(buf);
+}
+
+/*
+ * Formats 'us' microseconds as milliseconds with one decimal.
+ */
+static int fmt_ms(char* buf, int size, unsigned int us) {
+    return snprintf(buf, size, "%u.%u", us / 1000, us / 100 % 10);
+}
+
+/*
+ * Draws overlay every HUD_REFRESH calls, with averages of spans
+ * since the previous drawing.
+ */
+void hud_draw() {
+    unsigned int sorted[HUD_WINDOW];
+    unsigned long long sum = 0;
+    char line[64], a[12], b[12], c[12];
+    int n;
+
+    if (! hud_enabled || frames_to_draw-- > 0) {
+        return;
+    }
+    frames_to_draw = HUD_REFRESH - 1;
+
+    for (int i = 0; i < num_frames; i++) {
+        sorted[i] = frame_us[i];
+        sum += frame_us[i];
+    }
+    sort_uint(sorted, num_frames);
+    if (num_frames > 0 && sum > 0) {
+        unsigned int avg = (unsigned int)udiv64(sum, num_frames, 0);
+        snprintf(line, sizeof(line), "FPS %u", (unsigned int)udiv64(1000000ULL * num_frames, (unsigned int)sum, 0));
+        hud_line(0, line);
+        fmt_ms(a, sizeof(a), sorted[0]);
+        fmt_ms(b, sizeof(b), avg);
+        fmt_ms(c, sizeof(c), sorted[(num_frames * 99) / 100]);
+        snprintf(line, sizeof(line), "min/avg/p99 %s/%s/%s ms", a, b, c);
+        hud_line(1, line);
+    }
+    for (int i = 0; i < HUD_SPANS; i++) {
+        unsigned int us = 0;
+        if (span_count[i] > 0) {
+            us = (unsigned int)tsc_to_us(udiv64(span_sum[i], span_count[i], 0));
+        }
+        snprintf(line, sizeof(line), "%-12s %u us", span_names[i], us);
+        hud_line(2 + i, line);
+        span_sum[i] = 0;
+        span_count[i] = 0;
+    }
+    n = snprintf(line, sizeof(line), "key lat");
+    for (int i = 0; i < num_latencies && n < (int)sizeof(line) - 16; i++) {
+        line[n++] = ' ';
+        n += fmt_ms(line + n, sizeof(line) - n, latency_us[i]);
+    }
+    snprintf(line + n, sizeof(line) - n, " ms");
+    hud_line(2 + HUD_SPANS, line);
+}
@@ -0,0 +1,173 @@
+/*
+ * Contains descriptor tables, PIC and interrupt handling functions.
+ */
+
+#include "interrupts.h"
+#include "printf.h"
+
+#define PIC1_CMD   0x20
+#define PIC1_DATA  0x21
+#define PIC2_CMD   0xA0
+#define PIC2_DATA  0xA1
+#define PIC_EOI    0x20
+
+#define KERNEL_CS  0x08
+#define KERNEL_DS  0x10
+
+/* from 'interrupts.s' */
+extern unsigned int isr_table[NUM_ISRS];
+
+/*
+ * Descriptor table pointer for lgdt and lidt.
+ */
+struct table_ptr {
+    unsigned short limit;
+    unsigned int base;
+} __attribute__((packed));
+
+/*
+ * Flat segments: null, kernel code, kernel data.
+ * Multiboot doesn't guarantee GDT left by the loader is valid.
+ */
+static unsigned long long gdt[3] = {
+    0x0000000000000000ULL,
+    0x00CF9A000000FFFFULL,
+    0x00CF92000000FFFFULL,
+};
+
+static unsigned long long idt[NUM_ISRS];
+static isr_handler_t handlers[NUM_ISRS];
+static unsigned short irq_masks = 0xFFFF;
+
+/*
+ * Loads own GDT and reloads segment registers.
+ */
+static void gdt_init() {
+    struct table_ptr p = { sizeof(gdt) - 1, (unsigned int)gdt };
+    __asm__ volatile (
+        "lgdt %0\n"
+        "ljmp %1, $1f\n"
+        "1:\n"
+        "movw %w2, %%ds\n"
+        "movw %w2, %%es\n"
+        "movw %w2, %%fs\n"
+        "movw %w2, %%gs\n"
+        "movw %w2, %%ss\n"
+        :
+        : "m"(p), "i"(KERNEL_CS), "r"(KERNEL_DS)
+    );
+}
+
+/*
+ * Sets IDT entry 'vector' to interrupt gate calling 'addr'.
+ */
+static void idt_set_gate(int vector, unsigned int addr) {
+    idt[vector] = (addr & 0xFFFF) | (KERNEL_CS << 16) |
+        ((unsigned long long)(0x8E00 | (addr & 0xFFFF0000)) << 32);
+}
+
+static void io_wait() {
+    outb(0, 0x80);
+}
+
+/*
+ * Remaps PIC interrupts to vectors IRQ_BASE..IRQ_BASE+15
+ * and masks all of them.
+ */
+static void pic_remap() {
+    outb(0x11, PIC1_CMD);       /* ICW1: init, ICW4 needed */
+    io_wait();
+    outb(0x11, PIC2_CMD);
+    io_wait();
+    outb(IRQ_BASE, PIC1_DATA);  /* ICW2: vector offsets */
+    io_wait();
+    outb(IRQ_BASE + 8, PIC2_DATA);
+    io_wait();
+    outb(0x04, PIC1_DATA);      /* ICW3: slave at IRQ 2 */
+    io_wait();
+    outb(0x02, PIC2_DATA);
+    io_wait();
+    outb(0x01, PIC1_DATA);      /* ICW4: 8086 mode */
+    io_wait();
+    outb(0x01, PIC2_DATA);
+    io_wait();
+    outb(irq_masks & 0xFF, PIC1_DATA);
+    outb(irq_masks >> 8, PIC2_DATA);
+}
+
+/*
+ * Sets up GDT, IDT and PIC, then enables interrupts.
+ * All IRQs stay masked until a driver unmasks its own.
+ */
+void interrupts_init() {
+    struct table_ptr p = { sizeof(idt) - 1, (unsigned int)idt };
+    gdt_init();
+    for (int i = 0; i < NUM_ISRS; i++) {
+        idt_set_gate(i, isr_table[i]);
+    }
+    __asm__ volatile ("lidt %0" : : "m"(p));
+    pic_remap();
+    irq_unmask(2);  /* cascade */
+    __asm__ volatile ("sti");
+}
+
+/*
+ * Sets 'handler' for exception or interrupt 'vector'.
+ */
+void isr_install(int vector, isr_handler_t handler) {
+    handlers[vector] = handler;
+}
+
+/*
+ * Sets 'handler' for hardware interrupt line 'irq' and unmasks it.
+ */
+void irq_install(int irq, isr_handler_t handler) {
+    isr_install(IRQ_BASE + irq, handler);
+    irq_unmask(irq);
+}
+
+void irq_unmask(int irq) {
+    unsigned int flags = irq_save();
+    irq_masks &= ~(1 << irq);
+    if (irq < 8) {
+        outb(irq_masks & 0xFF, PIC1_DATA);
+    } else {
+        outb(irq_masks >> 8, PIC2_DATA);
+    }
+    irq_restore(flags);
+}
+
+void irq_mask(int irq) {
+    unsigned int flags = irq_save();
+    irq_masks |= (1 << irq);
+    if (irq < 8) {
+        outb(irq_masks & 0xFF, PIC1_DATA);
+    } else {
+        outb(irq_masks >> 8, PIC2_DATA);
+    }
+    irq_restore(flags);
+}
+
+/*
+ * Is called from 'isr_common' for every interrupt.
+ * Unhandled exceptions halt the machine.
+ */
+void isr_dispatch(struct regs* r) {
+    isr_handler_t handler = handlers[r->vector];
+    if (handler != NULL) {
+        handler(r);
+    } else if (r->vector < IRQ_BASE) {
+        screen_set_buffered(0);
+        printf("\nexception %u, error %x at eip %p\n", r->vector, r->error, r->eip);
+        screen_present();
+        for (;;) {
+            __asm__ volatile ("cli; hlt");
+        }
+    }
+    if (r->vector >= IRQ_BASE) {
+        if (r->vector >= IRQ_BASE + 8) {
+            outb(PIC_EOI, PIC2_CMD);
+        }
+        outb(PIC_EOI, PIC1_CMD);
+    }
+}
@@ -1,367 +1,265 @@
 /*
  * Contains keyboard input functions.
+ * Scancodes of set 1 are decoded by tables: scancode -> key code,
+ * with a second table for keys after the 0xE0 prefix, and
+ * key code x modifier state -> char.
  */
 
 #include "keyboard.h"
+#include "screen.h"
+#include "script.h"
 
-/* whether keys are pressed or not */
-char lshift_pressed = 0;
-char rshift_pressed = 0;
-char caps_pressed = 0;
+unsigned char key_mods = 0;
+unsigned int key_dropped = 0;
 
-/* ring buffer for polling keys */
-static unsigned char *ringbuf = 0;
-static unsigned int ringstart = 0, ringend = 0, ringsize = 1024;
+/* next scancode follows 0xE0 prefix */
+static char extended = 0;
+
+/* ring of polled key events: producer advances 'head', consumer 'tail' */
+static struct key_event events[KEY_EVENTS_SIZE];
+static unsigned int head = 0, tail = 0;
+
+/* bit per key code, set while key is down */
+static unsigned int key_state[KEY_MAX / 32];
+
+/* key codes of scancodes without prefix */
+static const unsigned char scancode_keys[0x80] = {
+    [0x01] = ESCAPE,
+    [0x02] = '1', [0x03] = '2', [0x04] = '3', [0x05] = '4', [0x06] = '5',
+    [0x07] = '6', [0x08] = '7', [0x09] = '8', [0x0a] = '9', [0x0b] = '0',
+    [0x0c] = '-', [0x0d] = '=', [0x0e] = KEY_BACKSPACE, [0x0f] = KEY_TAB,
+    [0x10] = 'q', [0x11] = 'w', [0x12] = 'e', [0x13] = 'r', [0x14] = 't',
+    [0x15] = 'y', [0x16] = 'u', [0x17] = 'i', [0x18] = 'o', [0x19] = 'p',
+    [0x1a] = '[', [0x1b] = ']', [0x1c] = ENTER, [0x1d] = KEY_CTRL,
+    [0x1e] = 'a', [0x1f] = 's', [0x20] = 'd', [0x21] = 'f', [0x22] = 'g',
+    [0x23] = 'h', [0x24] = 'j', [0x25] = 'k', [0x26] = 'l', [0x27] = ';',
+    [0x28] = '\'', [0x29] = '`', [0x2a] = KEY_LSHIFT, [0x2b] = '\\',
+    [0x2c] = 'z', [0x2d] = 'x', [0x2e] = 'c', [0x2f] = 'v', [0x30] = 'b',
+    [0x31] = 'n', [0x32] = 'm', [0x33] = ',', [0x34] = '.', [0x35] = '/',
+    [0x36] = KEY_RSHIFT, [0x38] = KEY_ALT, [0x39] = ' ', [0x3a] = KEY_CAPS,
+    [0x3b] = KEY_F1, [0x3c] = KEY_F1 + 1, [0x3d] = KEY_F1 + 2,
+    [0x3e] = KEY_F1 + 3, [0x3f] = KEY_F1 + 4, [0x40] = KEY_F1 + 5,
+    [0x41] = KEY_F1 + 6, [0x42] = KEY_F1 + 7, [0x43] = KEY_F1 + 8,
+    [0x44] = KEY_F1 + 9, [0x57] = KEY_F1 + 10, [0x58] = KEY_F12,
+    /* keypad with num lock off */
+    [0x48] = ARROW_UP, [0x49] = PAGE_UP, [0x4b] = ARROW_LEFT,
+    [0x4d] = ARROW_RIGHT, [0x50] = ARROW_DOWN, [0x51] = PAGE_DOWN,
+};
+
+/* key codes of scancodes after 0xE0 prefix */
+static const unsigned char scancode_keys_e0[0x80] = {
+    [0x1c] = ENTER, [0x1d] = KEY_CTRL, [0x38] = KEY_ALT,
+    [0x48] = ARROW_UP, [0x49] = PAGE_UP, [0x4b] = ARROW_LEFT,
+    [0x4d] = ARROW_RIGHT, [0x50] = ARROW_DOWN, [0x51] = PAGE_DOWN,
+};
+
+/* modifier bit changed by key */
+static const unsigned char key_mod_bits[KEY_MAX] = {
+    [KEY_LSHIFT] = KEY_MOD_LSHIFT,
+    [KEY_RSHIFT] = KEY_MOD_RSHIFT,
+    [KEY_CTRL] = KEY_MOD_CTRL,
+    [KEY_ALT] = KEY_MOD_ALT,
+    [KEY_CAPS] = KEY_MOD_CAPS,
+};
+
+/*
+ * Chars of keys by column: plain, shift, caps lock, caps lock and shift.
+ * 0 means key gives no char.
+ */
+static const char keymap[KEY_MAX][4] = {
+    [ENTER] = "\n\n\n\n", [KEY_BACKSPACE] = "\b\b\b\b", [KEY_TAB] = "\t\t\t\t",
+    [' '] = "    ",
+    ['1'] = "1!1!", ['2'] = "2@2@", ['3'] = "3#3#", ['4'] = "4$4$",
+    ['5'] = "5%5%", ['6'] = "6^6^", ['7'] = "7&7&", ['8'] = "8*8*",
+    ['9'] = "9(9(", ['0'] = "0)0)", ['-'] = "-_-_", ['='] = "=+=+",
+    ['['] = "[{[{", [']'] = "]}]}", [';'] = ";:;:", ['\''] = "'\"'\"",
+    ['`'] = "`~`~", ['\\'] = "\\|\\|", [','] = ",<,<", ['.'] = ".>.>",
+    ['/'] = "/?/?",
+    ['a'] = "aAAa", ['b'] = "bBBb", ['c'] = "cCCc", ['d'] = "dDDd",
+    ['e'] = "eEEe", ['f'] = "fFFf", ['g'] = "gGGg", ['h'] = "hHHh",
+    ['i'] = "iIIi", ['j'] = "jJJj", ['k'] = "kKKk", ['l'] = "lLLl",
+    ['m'] = "mMMm", ['n'] = "nNNn", ['o'] = "oOOo", ['p'] = "pPPp",
+    ['q'] = "qQQq", ['r'] = "rRRr", ['s'] = "sSSs", ['t'] = "tTTt",
+    ['u'] = "uUUu", ['v'] = "vVVv", ['w'] = "wWWw", ['x'] = "xXXx",
+    ['y'] = "yYYy", ['z'] = "zZZz",
+};
 
 /*
- * Initializes memory for ring buffer.
+ * Resets event ring and key state.
  * Must be called before any other keyboard function.
  */
 void key_init() {
-    ringbuf = malloc(ringsize);
+    head = tail = 0;
+    key_mods = 0;
+    for (int i = 0; i < KEY_MAX / 32; i++) {
+        key_state[i] = 0;
+    }
+}
+
+/*
+ * Decodes scancode 'c' and updates modifier state.
+ * Returns 0 if 'c' is a prefix, otherwise stores key code and pressed flag.
+ */
+static int key_scan(unsigned char c, int *key, char *pressed) {
+    unsigned char mod;
+    if (c == 0xe0) {
+        extended = 1;
+        return 0;
+    }
+    *pressed = ! (c & 0x80);
+    *key = (extended ? scancode_keys_e0 : scancode_keys)[c & 0x7f];
+    extended = 0;
+    mod = key_mod_bits[*key];
+    if (mod == KEY_MOD_CAPS) {
+        if (*pressed) {
+            key_mods ^= mod;
+        }
+    } else if (*pressed) {
+        key_mods |= mod;
+    } else {
+        key_mods &= ~mod;
+    }
+    return 1;
+}
+
+/*
+ * Returns char of pressed 'key' with current modifiers, 0 if there is none.
+ */
+static char key_char(int key) {
+    return keymap[key][((key_mods & KEY_MOD_SHIFT) != 0) | ((key_mods & KEY_MOD_CAPS) >> 1)];
 }
 
 /*
  * Returns first key code from enum KeyCode and pressed flag.
+ * Typematic repeats are returned as presses.
  */
 void key_decode(int *key, char *pressed) {
-    unsigned char c;
-    unsigned int ringoldstart = ringstart;
+    struct key_event* ev;
     *key = UNKNOWN;
     *pressed = 0;
-    if (ringstart == ringend) {
+    if (tail == head) {
         return;
     }
-    c = ringbuf[ringstart++];
-    if (ringstart == ringsize) {
-        ringstart = 0;
+    ev = &events[tail & (KEY_EVENTS_SIZE - 1)];
+    tail++;
+    *key = ev->key;
+    *pressed = ev->flags & KEY_EV_DOWN;
+}
+
+/*
+ * Moves up to 'max' pending events, oldest first, to 'evs'.
+ * Returns number of events taken.
+ */
+int key_events(struct key_event* evs, int max) {
+    int n = 0;
+    while (n < max && tail != head) {
+        evs[n++] = events[tail & (KEY_EVENTS_SIZE - 1)];
+        tail++;
     }
-    if (c == 0xe0) {
-        if (ringstart == ringend) {
-            ringstart = ringoldstart;
-            return;
-        }
-        c = ringbuf[ringstart++];
-        if (ringstart == ringsize) {
-            ringstart = 0;
+    return n;
+}
+
+/*
+ * Returns whether 'key' is down now.
+ */
+int key_down(int key) {
+    return (key_state[key >> 5] >> (key & 31)) & 1;
+}
+
+/*
+ * Switches consoles on Alt+F1 .. Alt+F4.
+ * Returns 1 if key was taken for that.
+ */
+static int key_console_switch(int key, char pressed) {
+    if ((key_mods & KEY_MOD_ALT) && key >= KEY_F1 && key < KEY_F1 + NR_CONSOLES) {
+        if (pressed) {
+            console_show(key - KEY_F1);
         }
+        return 1;
     }
-    *pressed = (c >= 0x01) && (c <= 0x6D);
-    c &= ~0x80;
-    if (c == 0x01) *key = ESCAPE;
-    if (c == 0x48) *key = ARROW_UP;
-    if (c == 0x4b) *key = ARROW_LEFT;
-    if (c == 0x4d) *key = ARROW_RIGHT;
-    if (c == 0x50) *key = ARROW_DOWN;
-    if (c == 0x1c) *key = ENTER;
+    return 0;
 }
 
 /*
- * Clears key buffer.
+ * Drops pending key events. Key state is kept.
  */
 void key_buffer_clear() {
-    ringstart = 0;
-    ringend = 0;
+    tail = head;
+}
+
+/*
+ * Decodes scancode 'c' into key event ring, as if it was read
+ * from port 0x60.
+ */
+void key_inject(unsigned char c) {
+    struct key_event* ev;
+    unsigned int bit;
+    int key;
+    char pressed;
+    if (! key_scan(c, &key, &pressed) || key_console_switch(key, pressed)) {
+        return;
+    }
+    if (head - tail >= KEY_EVENTS_SIZE) {
+        key_dropped++;
+        return;
+    }
+    ev = &events[head & (KEY_EVENTS_SIZE - 1)];
+    ev->tsc = rdtsc();
+    ev->key = key;
+    ev->mods = key_mods;
+    bit = 1u << (key & 31);
+    if (pressed) {
+        ev->flags = KEY_EV_DOWN | ((key_state[key >> 5] & bit) ? KEY_EV_REPEAT : 0);
+        key_state[key >> 5] |= bit;
+    } else {
+        ev->flags = 0;
+        key_state[key >> 5] &= ~bit;
+    }
+    head++;
 }
 
 /*
  * Is called mainly from delay_short from time.c.
- * Stores key strokes to buffer every short time if using delay.
+ * Stores key events to ring every short time if using delay,
+ * and plays key script if there is one.
  */
 void key_poll() {
     unsigned char status = inb(0x64);
     if ((status & 1) && ((status & 0x20) == 0)) {
-        ringbuf[ringend++] = inb(0x60);
-        if (ringend == ringsize) {
-            ringend = 0;
-        }
+        key_inject(inb(0x60));
+    }
+    if (script_active) {
+        script_poll();
     }
 }
 
+/*
+ * Returns number of key events waiting in ring.
+ */
+unsigned int key_queued() {
+    return head - tail;
+}
+
 /*
  * Reads next key stroke like getchar.
+ * Returns -1 if there is none or it gives no char.
  */
 int get_char() {
     unsigned char status = inb(0x64);
+    int key;
+    char pressed, c;
     if ((status & 1) && ((status & 0x20) == 0)) {
-        int c = inb(0x60);
-        char shift_pressed = lshift_pressed | rshift_pressed;
-        switch (c) {
-        case 2:
-            if (shift_pressed) {
-                return '!';
-            }
-            return '1';
-        case 3:
-            if (shift_pressed) {
-                return '@';
-            }
-            return '2';
-        case 4:
-            if (shift_pressed) {
-                return '#';
-            }
-            return '3';
-        case 5:
-            if (shift_pressed) {
-                return '$';
-            }
-            return '4';
-        case 6:
-            if (shift_pressed) {
-                return '%';
-            }
-            return '5';
-        case 7:
-            if (shift_pressed) {
-                return '^';
-            }
-            return '6';
-        case 8:
-            if (shift_pressed) {
-                return '&';
-            }
-            return '7';
-        case 9:
-            if (shift_pressed) {
-                return '*';
-            }
-            return '8';
-        case 0xa:
-            if (shift_pressed) {
-                return '(';
-            }
-            return '9';
-        case 0xb:
-            if (shift_pressed) {
-                return ')';
-            }
-            return '0';
-        case 0xc:
-            if (shift_pressed) {
-                return '_';
-            }
-            return '-';
-        case 0xd:
-            if (shift_pressed) {
-                return '+';
-            }
-            return '=';
-        case 0xe: // Backspace press
-            return '\b';
-        case 0xf: // Tab press
-            return '\t';
-        case 0x10:
-            if (shift_pressed | caps_pressed) {
-                return 'Q';
-            }
-            return 'q';
-        case 0x11:
-            if (shift_pressed | caps_pressed) {
-                return 'W';
-            }
-            return 'w';
-        case 0x12:
-            if (shift_pressed | caps_pressed) {
-                return 'E';
-            }
-            return 'e';
-        case 0x13:
-            if (shift_pressed | caps_pressed) {
-                return 'R';
-            }
-            return 'r';
-        case 0x14:
-            if (shift_pressed | caps_pressed) {
-                return 'T';
-            }
-            return 't';
-        case 0x15:
-            if (shift_pressed | caps_pressed) {
-                return 'Y';
-            }
-            return 'y';
-        case 0x16:
-            if (shift_pressed | caps_pressed) {
-                return 'U';
-            }
-            return 'u';
-        case 0x17:
-            if (shift_pressed | caps_pressed) {
-                return 'I';
-            }
-            return 'i';
-        case 0x18:
-            if (shift_pressed | caps_pressed) {
-                return 'O';
-            }
-            return 'o';
-        case 0x19:
-            if (shift_pressed | caps_pressed) {
-                return 'P';
-            }
-            return 'p';
-        case 0x1a:
-            if (shift_pressed) {
-                return '{';
-            }
-            return '[';
-        case 0x1b:
-            if (shift_pressed) {
-                return '}';
-            }
-            return ']';
-        case 0x1c: // Enter press
-            return '\n';
-        case 0x1d: // Lctrl press
-            return -1;
-        case 0x1e:
-            if (shift_pressed | caps_pressed) {
-                return 'A';
-            }
-            return 'a';
-        case 0x1f:
-            if (shift_pressed | caps_pressed) {
-                return 'S';
-            }
-            return 's';
-        case 0x20:
-            if (shift_pressed | caps_pressed) {
-                return 'D';
-            }
-            return 'd';
-        case 0x21:
-            if (shift_pressed | caps_pressed) {
-                return 'F';
-            }
-            return 'f';
-        case 0x22:
-            if (shift_pressed | caps_pressed) {
-                return 'G';
-            }
-            return 'g';
-        case 0x23:
-            if (shift_pressed | caps_pressed) {
-                return 'H';
-            }
-            return 'h';
-        case 0x24:
-            if (shift_pressed | caps_pressed) {
-                return 'J';
-            }
-            return 'j';
-        case 0x25:
-            if (shift_pressed | caps_pressed) {
-                return 'K';
-            }
-            return 'k';
-        case 0x26:
-            if (shift_pressed | caps_pressed) {
-                return 'L';
-            }
-            return 'l';
-        case 0x27:
-            if (shift_pressed) {
-                return ':';
-            }
-            return ';';
-        case 0x28:
-            if (shift_pressed) {
-                return '\"';
-            }
-            return '\'';
-        case 0x29:
-            if (shift_pressed) {
-                return '~';
-            }
-            return '`';
-        case 0x2a: // Lshift press
-            lshift_pressed = 1;
-            return -1;
-        case 0x2b:
-            if (shift_pressed) {
-                return '|';
-            }
-            return '\\';
-        case 0x2c:
-            if (shift_pressed | caps_pressed) {
-                return 'Z';
-            }
-            return 'z';
-        case 0x2d:
-            if (shift_pressed | caps_pressed) {
-                return 'X';
-            }
-            return 'x';
-        case 0x2e:
-            if (shift_pressed | caps_pressed) {
-                return 'C';
-            }
-            return 'c';
-        case 0x2f:
-            if (shift_pressed | caps_pressed) {
-                return 'V';
-            }
-            return 'v';
-        case 0x30:
-            if (shift_pressed | caps_pressed) {
-                return 'B';
-            }
-            return 'b';
-        case 0x31:
-            if (shift_pressed | caps_pressed) {
-                return 'N';
-            }
-            return 'n';
-        case 0x32:
-            if (shift_pressed | caps_pressed) {
-                return 'M';
-            }
-            return 'm';
-        case 0x33:
-            if (shift_pressed) {
-                return '<';
-            }
-            return ',';
-        case 0x34:
-            if (shift_pressed) {
-                return '>';
-            }
-            return '.';
-        case 0x35:
-            if (shift_pressed) {
-                return '?';
-            }
-            return '/';
-        case 0x36: // Rshift press
-            rshift_pressed = 1;
-            return -1;
-        case 0x37: // Numpad '*' press
-            return -1;
-        case 0x38: // Lalt press
-            return -1;
-        case 0x39: // Space press
-            return ' ';
-        case 0x3a: // Caps press
-            caps_pressed = !caps_pressed;
-            return -1;
-        case 0x48: // Arrow up press
-            return -1;
-        case 0x4b: // Arrow left press
-            return -1;
-        case 0x4d: // Arrow right press
-            return -1;
-        case 0x50: // Arrow down press
-            return -1;  
-        case 0xaa: // Lshift release
-            lshift_pressed = 0;
-            return -1;
-        case 0xb6: // Rshift release
-            rshift_pressed = 0;
-            return -1;
-        case 0xba: // Caps release
+        if (! key_scan(inb(0x60), &key, &pressed) || ! pressed ||
+                key_console_switch(key, pressed)) {
             return -1;
         }
+        if (key == PAGE_UP) {
+            scrollback_page(1);
+        } else if (key == PAGE_DOWN) {
+            scrollback_page(-1);
+        } else if ((c = key_char(key)) != 0) {
+            return c;
+        }
     }
     return -1;
 }
@@ -0,0 +1,69 @@
+/*
+ * Contains input-to-photon latency histogram.
+ * Latency is time from a key event polled at port 0x60 to the end of
+ * presenting the first frame which reflects it. Recording is O(1),
+ * percentiles are computed from the histogram when asked.
+ */
+
+#include "latency.h"
+#include "serial.h"
+#include "time.h"
+
+static unsigned int buckets[LATENCY_BUCKETS];
+static unsigned int count = 0;
+static unsigned int max_us = 0;
+
+void latency_reset() {
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        buckets[i] = 0;
+    }
+    count = max_us = 0;
+}
+
+void latency_record(unsigned long long cycles) {
+    unsigned int us = (unsigned int)tsc_to_us(cycles);
+    unsigned int i = us / LATENCY_BUCKET_US;
+    buckets[i < LATENCY_BUCKETS ? i : LATENCY_BUCKETS - 1]++;
+    count++;
+    if (us > max_us) {
+        max_us = us;
+    }
+}
+
+/*
+ * Returns upper bound of the bucket holding 'rank'-th latency, at most max.
+ */
+static unsigned int percentile(unsigned int rank) {
+    unsigned int seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen > rank) {
+            unsigned int us = (i + 1) * LATENCY_BUCKET_US;
+            return us < max_us ? us : max_us;
+        }
+    }
+    return max_us;
+}
+
+void latency_get(struct latency_stats* s) {
+    s->count = count;
+    s->max = max_us;
+    if (count == 0) {
+        s->p50 = s->p90 = s->p99 = 0;
+        return;
+    }
+    s->p50 = percentile(count / 2);
+    s->p90 = percentile((unsigned int)udiv64((unsigned long long)count * 90, 100, 0));
+    s->p99 = percentile((unsigned int)udiv64((unsigned long long)count * 99, 100, 0));
+}
+
+/*
+ * Prints latency percentiles to serial port:
+ *   LATENCY count=<n> p50_us=<us> p90_us=<us> p99_us=<us> max_us=<us>
+ */
+void latency_report() {
+    struct latency_stats s;
+    latency_get(&s);
+    serial_printf("LATENCY count=%u p50_us=%u p90_us=%u p99_us=%u max_us=%u\n",
+                  s.count, s.p50, s.p90, s.p99, s.max);
+}
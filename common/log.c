@@ -0,0 +1,137 @@
+/*
+ * Contains in-memory kernel log and deferred binary logging.
+ * Text is appended to a ring, oldest text is overwritten when it is full.
+ * log_event only stores format pointer, time and argument words to a
+ * per-processor ring; log_drain formats them later to selected output.
+ */
+
+#include "log.h"
+#include "printf.h"
+#include "string.h"
+#include "time.h"
+
+static char logbuf[LOG_SIZE];
+static unsigned int loghead = 0;    /* total chars ever written */
+
+/*
+ * Ring of binary records owned by one processor.
+ * Slot is reserved by atomic increment of 'head', so an interrupt
+ * handler may safely log while interrupted code does.
+ * When ring is full, oldest records are overwritten.
+ */
+static struct log_ring {
+    log_rec_t recs[LOG_RING_SIZE];
+    unsigned int head;          /* number of records ever reserved */
+    unsigned int tail;          /* number of records drained or lost */
+} rings[NR_CPUS];
+
+unsigned int log_lost = 0;
+
+static struct printf_sink* output = &log_sink;
+static unsigned long long log_base = 0;
+
+/*
+ * Selects output of drained records: "serial", "console",
+ * or in-memory text log for anything else.
+ */
+void log_init(const char* out) {
+    log_base = rdtsc();
+    if (out != NULL && strcmp(out, "serial") == 0) {
+        output = &serial_sink;
+    } else if (out != NULL && strcmp(out, "console") == 0) {
+        output = &console_sink;
+    } else {
+        output = &log_sink;
+    }
+}
+
+/*
+ * Appends 'len' chars from 'buf' to log ring.
+ */
+void log_write(const char* buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        logbuf[loghead & (LOG_SIZE - 1)] = buf[i];
+        loghead++;
+    }
+}
+
+int log_printf(const char* format, ...) {
+    va_list ap;
+    int r;
+    va_start(ap, format);
+    r = vsink_printf(&log_sink, format, ap);
+    va_end(ap);
+    return r;
+}
+
+/*
+ * Records event in O(1) without formatting, safe in interrupt handlers.
+ * Arguments may take up to LOG_ARGS_MAX words; '%s' arguments must
+ * stay valid until drained, e.g. string constants.
+ */
+void log_event(const char* format, ...) {
+    struct log_ring* ring = &rings[cpu_id()];
+    log_rec_t* rec;
+    va_list ap;
+    rec = &ring->recs[__sync_fetch_and_add(&ring->head, 1) & (LOG_RING_SIZE - 1)];
+    rec->format = NULL;
+    rec->tsc = rdtsc();
+    /* words past the last argument are copied too, they are never used */
+    va_start(ap, format);
+    for (int i = 0; i < LOG_ARGS_MAX; i++) {
+        rec->args[i] = va_arg(ap, unsigned int);
+    }
+    va_end(ap);
+    __sync_synchronize();
+    rec->format = format;
+}
+
+/*
+ * Formats up to 'max' recorded events, oldest first, to selected output.
+ * Returns number of formatted events.
+ */
+int log_drain(int max) {
+    int n = 0;
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        struct log_ring* ring = &rings[cpu];
+        while (n < max && ring->tail != ring->head) {
+            log_rec_t rec;
+            unsigned int us;
+            unsigned long long ms;
+            if (ring->head - ring->tail > LOG_RING_SIZE) {
+                log_lost += ring->head - ring->tail - LOG_RING_SIZE;
+                ring->tail = ring->head - LOG_RING_SIZE;
+            }
+            rec = ring->recs[ring->tail & (LOG_RING_SIZE - 1)];
+            if (rec.format == NULL) {
+                break;          /* still being written */
+            }
+            if (ring->head - ring->tail > LOG_RING_SIZE) {
+                continue;       /* overwritten while copied */
+            }
+            ring->tail++;
+            ms = udiv64(tsc_to_us(rec.tsc - log_base), 1000, &us);
+            sink_printf(output, "[%llu.%03u] ", ms, us);
+            /* argument words are laid out like cdecl stack arguments,
+               which is what va_list points to on i386 */
+            vsink_printf(output, rec.format, (va_list)rec.args);
+            n++;
+        }
+    }
+    return n;
+}
+
+/*
+ * Copies text log contents, oldest first, to serial port.
+ */
+void log_dump() {
+    unsigned int start = loghead > LOG_SIZE ? loghead - LOG_SIZE : 0;
+    unsigned int first = start & (LOG_SIZE - 1);
+    unsigned int len = loghead - start;
+    if (first + len > LOG_SIZE) {
+        serial_write(logbuf + first, LOG_SIZE - first);
+        len -= LOG_SIZE - first;
+        first = 0;
+    }
+    serial_write(logbuf + first, len);
+}
@@ -31,6 +31,9 @@
  */
 
 #include "printf.h"
+#include "log.h"
+#include "string.h"
+#include "bench.h"
 
 /* printf 20071010
 
@@ -67,9 +70,10 @@
    %    %
 */
 
-struct snputchar_data {
-        char *buf;
+struct printf_out {
+        char buf[PRINTF_BUF_SIZE];
         size_t len;
+        struct printf_sink *sink;
 };
 
 struct parse_data {
@@ -105,77 +109,50 @@ struct parse_data {
 #define FLAG_MINUS              0x2000000
 #define FLAG_PLUS               0x4000000
 
-#define PUTCHAR(c) do { if (func (c, data) < 0) goto error; n++; } while (0)
-
-static unsigned long long sub10[] = {
-        10000000000000000000ULL,
-        1000000000000000000ULL,
-        100000000000000000ULL,
-        10000000000000000ULL,
-        1000000000000000ULL,
-        100000000000000ULL,
-        10000000000000ULL,
-        1000000000000ULL,
-        100000000000ULL,
-        10000000000ULL,
-        1000000000ULL,
-        100000000ULL,
-        10000000ULL,
-        1000000ULL,
-        100000ULL,
-        10000ULL,
-        1000ULL,
-        100ULL,
-        10ULL,
-        1ULL,
-        0ULL,
+#define PUTCHAR(c) do { if (out->len == sizeof (out->buf) && \
+                            flush_out (out) < 0) goto error; \
+                        out->buf[out->len++] = (c); n++; } while (0)
+
+/* "00" "01" ... "99", so that two decimal digits cost one lookup */
+static const char digits100[201] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+static const unsigned int pow10[] = {
+        10U,
+        100U,
+        1000U,
+        10000U,
+        100000U,
+        1000000U,
+        10000000U,
+        100000000U,
+        1000000000U,
 };
 
-static unsigned long long sub8[] = {
-        01000000000000000000000ULL,
-        0100000000000000000000ULL,
-        010000000000000000000ULL,
-        01000000000000000000ULL,
-        0100000000000000000ULL,
-        010000000000000000ULL,
-        01000000000000000ULL,
-        0100000000000000ULL,
-        010000000000000ULL,
-        01000000000000ULL,
-        0100000000000ULL,
-        010000000000ULL,
-        01000000000ULL,
-        0100000000ULL,
-        010000000ULL,
-        01000000ULL,
-        0100000ULL,
-        010000ULL,
-        01000ULL,
-        0100ULL,
-        010ULL,
-        01ULL,
-        00ULL,
-};
+/* bounds of .rodata, set by linker script */
+extern const char rodata_start[], rodata_end[];
 
-static unsigned long long sub16[] = {
-        0x1000000000000000ULL,
-        0x100000000000000ULL,
-        0x10000000000000ULL,
-        0x1000000000000ULL,
-        0x100000000000ULL,
-        0x10000000000ULL,
-        0x1000000000ULL,
-        0x100000000ULL,
-        0x10000000ULL,
-        0x1000000ULL,
-        0x100000ULL,
-        0x10000ULL,
-        0x1000ULL,
-        0x100ULL,
-        0x10ULL,
-        0x1ULL,
-        0x0ULL,
-};
+static struct printf_format format_cache[PRINTF_CACHE_SIZE];
+
+static int
+flush_out (struct printf_out *out)
+{
+        int r = 0;
+
+        if (out->len)
+                r = out->sink->write (out->buf, out->len, out->sink->data);
+        out->len = 0;
+        return r;
+}
 
 static int
 parse_format (const char **format, int *width, int *precision)
@@ -295,34 +272,118 @@ parse_conversion:
         return r;
 }
 
+/* v / 100 for every 32-bit v, as a multiply by 2^37 / 100 rounded up.
+   The 32x32->64 multiply is one mull, much cheaper than divl. */
+static inline unsigned int
+div100 (unsigned int v)
+{
+        return (unsigned int)(((unsigned long long)v * 0x51EB851FU) >> 37);
+}
+
 static int
-valconv (unsigned long long val, char *buf, unsigned long long *sub, char *str)
+ndigits10 (unsigned int v)
 {
-        int n = 0;
-        int digit;
+        int n = 1;
 
-        if (val == 0) {
-                *buf++ = '0';
-                return 1;
+        while (n < 10 && v >= pow10[n - 1])
+                n++;
+        return n;
+}
+
+/* Writes exactly n decimal digits of v backwards from end. */
+static void
+put10 (unsigned int v, char *end, int n)
+{
+        unsigned int q;
+        const char *d;
+
+        while (n >= 2) {
+                q = div100 (v);
+                d = &digits100[(v - q * 100) * 2];
+                *--end = d[1];
+                *--end = d[0];
+                v = q;
+                n -= 2;
         }
-        while (val < *sub)
-                sub++;
-        while (*sub) {
-                digit = 0;
-                while (val >= *sub) {
-                        digit++;
-                        val -= *sub;
+        if (n)
+                *--end = '0' + v;
+}
+
+/* The digit count is known first, so digits are placed in their final
+   positions. 64-bit values are split into 32-bit chunks of 9 digits. */
+static int
+conv10 (unsigned long long val, char *buf)
+{
+        unsigned int hi, mid, lo;
+        int n;
+
+        if (!(val >> 32)) {
+                n = ndigits10 ((unsigned int)val);
+                put10 ((unsigned int)val, buf + n, n);
+                return n;
+        }
+        val = udiv64 (val, 1000000000U, &lo);
+        if (val >= 1000000000ULL) {
+                hi = (unsigned int)udiv64 (val, 1000000000U, &mid);
+                n = ndigits10 (hi);
+                put10 (hi, buf + n, n);
+                put10 (mid, buf + n + 9, 9);
+                n += 9;
+        } else {
+                n = ndigits10 ((unsigned int)val);
+                put10 ((unsigned int)val, buf + n, n);
+        }
+        put10 (lo, buf + n + 9, 9);
+        return n + 9;
+}
+
+/* Octal and hexadecimal: digit count from the highest set bit. */
+static int
+conv2n (unsigned long long val, char *buf, int shift, const char *str)
+{
+        unsigned int hi = (unsigned int)(val >> 32);
+        unsigned int lo = (unsigned int)val;
+        unsigned int mask = (1U << shift) - 1;
+        int bits, n;
+        char *p;
+
+        if (hi)
+                bits = 64 - __builtin_clz (hi);
+        else
+                bits = 32 - __builtin_clz (lo | 1);
+        n = (bits + shift - 1) / shift;
+        p = buf + n;
+        if (!hi) {
+                while (p > buf) {
+                        *--p = str[lo & mask];
+                        lo >>= shift;
+                }
+        } else {
+                while (p > buf) {
+                        *--p = str[(unsigned int)val & mask];
+                        val >>= shift;
                 }
-                *buf++ = str[digit];
-                n++;
-                sub++;
         }
         return n;
 }
 
+static int
+valconv (unsigned long long val, char *buf, int f)
+{
+        if (f & CONVERSION_DECIMAL)
+                return conv10 (val, buf);
+        if (f & CONVERSION_OCTAL)
+                return conv2n (val, buf, 3, "01234567");
+        if (f & CONVERSION_CAPITAL)
+                return conv2n (val, buf, 4, "0123456789ABCDEF");
+        if (f & CONVERSION_HEXADECIMAL)
+                return conv2n (val, buf, 4, "0123456789abcdef");
+        return 0;
+}
+
 static int
 do_conversion_int (unsigned long long val, int f, int width, int precision,
-                   int (*func)(int c, void *data), void *data)
+                   struct printf_out *out)
 {
         int len = 0;
         int n = 0;
@@ -335,14 +396,7 @@ do_conversion_int (unsigned long long val, int f, int width, int precision,
         }
         if ((f & HAS_PRECISION) && precision == 0 && val == 0)
                 return 0;
-        if (f & CONVERSION_DECIMAL)
-                len = valconv (val, buf, sub10, "0123456789");
-        else if (f & CONVERSION_OCTAL)
-                len = valconv (val, buf, sub8, "01234567");
-        else if ((f & CONVERSION_HEXADECIMAL) && (f & CONVERSION_CAPITAL))
-                len = valconv (val, buf, sub16, "0123456789ABCDEF");
-        else if (f & CONVERSION_HEXADECIMAL)
-                len = valconv (val, buf, sub16, "0123456789abcdef");
+        len = valconv (val, buf, f);
         if ((f & HAS_PRECISION) && precision > len)
                 leftzero = precision - len;
         if (!(f & CONVERSION_DECIMAL) &&
@@ -399,7 +453,7 @@ error:
 
 static int
 do_conversion_string (const char *str, int f, int width, int precision,
-                      int (*func)(int c, void *data), void *data)
+                      struct printf_out *out)
 {
         int len;
         int n = 0;
@@ -426,123 +480,317 @@ error:
 }
 
 static int
-do_printf (const char *format, va_list ap, int (*func)(int c, void *data),
-           void *data)
+put_string (struct printf_out *out, const char *s, size_t len)
+{
+        size_t room;
+
+        while (len) {
+                if (out->len == sizeof (out->buf) && flush_out (out) < 0)
+                        return -1;
+                room = sizeof (out->buf) - out->len;
+                if (room > len)
+                        room = len;
+                memcpy (out->buf + out->len, s, room);
+                out->len += room;
+                s += room;
+                len -= room;
+        }
+        return 0;
+}
+
+static int
+parse_spec (const char **format, int *width, int *precision)
+{
+        int f;
+
+        f = parse_format (format, width, precision);
+        if (f & LENGTH_INTMAX)
+                f |= LENGTH_LONGLONG;
+        else if (f & LENGTH_SIZE)
+                f |= LENGTH_LONG;
+        else if (f & LENGTH_PTRDIFF)
+                f |= LENGTH_LONG;
+        return f;
+}
+
+static int
+do_conversion (int f, int width, int precision, va_list *ap,
+               struct printf_out *out)
+{
+        int n = 0;
+
+        if (f & CONVERSION_NONE) {
+                PUTCHAR ('%');
+        } else if (f & CONVERSION_INT) {
+                long long intval;
+                unsigned long long uintval;
+
+                if (f & LENGTH_CHAR)
+                        intval = (long long)va_arg (*ap, int);
+                else if (f & LENGTH_SHORT)
+                        intval = (long long)va_arg (*ap, int);
+                else if (f & LENGTH_LONGLONG)
+                        intval = va_arg (*ap, long long);
+                else if (f & LENGTH_LONG)
+                        intval = (long long)va_arg (*ap, long);
+                else
+                        intval = (long long)va_arg (*ap, int);
+                if (intval < 0) {
+                        uintval = (unsigned long long)-intval;
+                        f |= FLAG_MINUS;
+                } else {
+                        uintval = (unsigned long long)intval;
+                        f |= FLAG_PLUS;
+                }
+                n += do_conversion_int (uintval, f, width, precision, out);
+        } else if (f & CONVERSION_UINT) {
+                unsigned long long uintval;
+
+                if (f & LENGTH_CHAR)
+                        uintval = (unsigned long long)
+                                va_arg (*ap, unsigned int);
+                else if (f & LENGTH_SHORT)
+                        uintval = (unsigned long long)
+                                va_arg (*ap, unsigned int);
+                else if (f & LENGTH_LONGLONG)
+                        uintval = va_arg (*ap, unsigned long long);
+                else if (f & LENGTH_LONG)
+                        uintval = (unsigned long long)
+                                va_arg (*ap, unsigned long);
+                else
+                        uintval = (unsigned long long)
+                                va_arg (*ap, unsigned int);
+                n += do_conversion_int (uintval, f, width, precision, out);
+        } else if (f & CONVERSION_VOIDP) {
+                void *voidpval;
+                unsigned long long uintval;
+
+                voidpval = va_arg (*ap, void *);
+                uintval = (unsigned long long)(unsigned long)voidpval;
+                n += do_conversion_int (uintval, f, width, precision, out);
+        } else if (f & CONVERSION_CHARP) {
+                char *charpval;
+
+                charpval = va_arg (*ap, char *);
+                if (charpval == NULL)
+                        charpval = "(null)";
+                n += do_conversion_string (charpval, f, width, precision,
+                                           out);
+        } else {
+                n += do_conversion_string ("FORMAT ERROR", CONVERSION_CHARP,
+                                           0, 0, out);
+        }
+error:
+        return n;
+}
+
+/* Splits 'format' into literal text and parsed conversions. Returns -1
+   if it has more than PRINTF_SPECS_MAX conversions. */
+int
+printf_compile (struct printf_format *fmt, const char *format)
+{
+        struct printf_spec *s;
+        const char *lit;
+        int i = 0;
+
+        fmt->format = format;
+        fmt->nspecs = -1;
+        for (;;) {
+                if (i == PRINTF_SPECS_MAX)
+                        return -1;
+                lit = format;
+                while (*format != '\0' && *format != '%')
+                        format++;
+                s = &fmt->specs[i++];
+                s->lit = lit;
+                s->litlen = format - lit;
+                if (*format == '\0') {
+                        s->f = END_STRING;
+                        break;
+                }
+                format++;
+                s->f = parse_spec (&format, &s->width, &s->precision);
+                if (s->f == END_STRING)
+                        break;
+        }
+        fmt->nspecs = i;
+        return 0;
+}
+
+static int
+do_printf_compiled (const struct printf_format *fmt, va_list *ap,
+                    struct printf_out *out)
+{
+        const struct printf_spec *s;
+        int n = 0;
+
+        for (s = fmt->specs; ; s++) {
+                if (put_string (out, s->lit, s->litlen) < 0)
+                        break;
+                n += s->litlen;
+                if (s->f == END_STRING)
+                        break;
+                n += do_conversion (s->f, s->width, s->precision, ap, out);
+        }
+        return n;
+}
+
+/* Returns compiled form of 'format' if it is a constant in .rodata,
+   compiling it on first use. Other formats may change at the same
+   address, so they are not cached. */
+static const struct printf_format *
+format_cache_lookup (const char *format)
+{
+        struct printf_format *fmt;
+        unsigned int addr, flags;
+
+        if (format < rodata_start || format >= rodata_end)
+                return NULL;
+        addr = (unsigned int)(unsigned long)format;
+        fmt = &format_cache[(addr ^ (addr >> 7)) & (PRINTF_CACHE_SIZE - 1)];
+        if (fmt->format != format) {
+                flags = irq_save ();
+                printf_compile (fmt, format);
+                irq_restore (flags);
+        }
+        if (fmt->nspecs < 0)
+                return NULL;
+        return fmt;
+}
+
+static int
+do_printf (const char *format, va_list ap, struct printf_out *out)
 {
+        const struct printf_format *fmt;
+        va_list args;
         char c;
         int n, f;
         int width, precision;
 
         n = 0;
+        va_copy (args, ap);
+        fmt = format_cache_lookup (format);
+        if (fmt != NULL) {
+                n = do_printf_compiled (fmt, &args, out);
+                goto error;
+        }
         while ((c = *format++) != '\0') {
                 if (c == '%') {
-                        f = parse_format (&format, &width, &precision);
-                        if (f & LENGTH_INTMAX)
-                                f |= LENGTH_LONGLONG;
-                        else if (f & LENGTH_SIZE)
-                                f |= LENGTH_LONG;
-                        else if (f & LENGTH_PTRDIFF)
-                                f |= LENGTH_LONG;
-                        if (f == END_STRING) {
+                        f = parse_spec (&format, &width, &precision);
+                        if (f == END_STRING)
                                 break;
-                        } else if (f & CONVERSION_NONE) {
-                                PUTCHAR ('%');
-                        } else if (f & CONVERSION_INT) {
-                                long long intval;
-                                unsigned long long uintval;
-
-                                if (f & LENGTH_CHAR)
-                                        intval = (long long)va_arg (ap, int);
-                                else if (f & LENGTH_SHORT)
-                                        intval = (long long)va_arg (ap, int);
-                                else if (f & LENGTH_LONGLONG)
-                                        intval = va_arg (ap, long long);
-                                else if (f & LENGTH_LONG)
-                                        intval = (long long)va_arg (ap, long);
-                                else
-                                        intval = (long long)va_arg (ap, int);
-                                if (intval < 0) {
-                                        uintval = (unsigned long long)-intval;
-                                        f |= FLAG_MINUS;
-                                } else {
-                                        uintval = (unsigned long long)intval;
-                                        f |= FLAG_PLUS;
-                                }
-                                n += do_conversion_int (uintval, f, width,
-                                                        precision, func, data);
-                                continue;
-                        } else if (f & CONVERSION_UINT) {
-                                unsigned long long uintval;
-
-                                if (f & LENGTH_CHAR)
-                                        uintval = (unsigned long long)
-                                                va_arg (ap, unsigned int);
-                                else if (f & LENGTH_SHORT)
-                                        uintval = (unsigned long long)
-                                                va_arg (ap, unsigned int);
-                                else if (f & LENGTH_LONGLONG)
-                                        uintval = va_arg (ap,
-                                                          unsigned long long);
-                                else if (f & LENGTH_LONG)
-                                        uintval = (unsigned long long)
-                                                va_arg (ap, unsigned long);
-                                else
-                                        uintval = (unsigned long long)
-                                                va_arg (ap, unsigned int);
-                                n += do_conversion_int (uintval, f, width,
-                                                        precision, func, data);
-                        } else if (f & CONVERSION_VOIDP) {
-                                void *voidpval;
-                                unsigned long long uintval;
-
-                                voidpval = va_arg (ap, void *);
-                                uintval = (unsigned long long)
-                                        (unsigned long)voidpval;
-                                n += do_conversion_int (uintval, f, width,
-                                                        precision, func, data);
-                        } else if (f & CONVERSION_CHARP) {
-                                char *charpval;
-
-                                charpval = va_arg (ap, char *);
-                                if (charpval == NULL)
-                                        charpval = "(null)";
-                                n += do_conversion_string (charpval, f, width,
-                                                           precision, func,
-                                                           data);
-                        } else {
-                                n += do_conversion_string ("FORMAT ERROR",
-                                                           CONVERSION_CHARP,
-                                                           0, 0, func, data);
-                        }
+                        n += do_conversion (f, width, precision, &args, out);
                 } else {
                         PUTCHAR (c);
                 }
         }
 error:
+        va_end (args);
         return n;
 }
 
 static int
-do_putchar (int c, void *data)
+console_sink_write (const char *buf, size_t len, void *data)
+{
+        console_write (buf, len);
+        return 0;
+}
+
+static int
+serial_sink_write (const char *buf, size_t len, void *data)
+{
+        serial_write (buf, len);
+        return 0;
+}
+
+static int
+log_sink_write (const char *buf, size_t len, void *data)
 {
-        putchar (c);
+        log_write (buf, len);
         return 0;
 }
 
 static int
-do_snputchar (int c, void *data)
+mem_sink_write (const char *buf, size_t len, void *data)
 {
-        struct snputchar_data *p;
+        struct printf_mem *p;
+        size_t i;
 
         p = data;
-        if (!p->len)
-                return -1;
-        if (!--p->len)
-                c = '\0';
-        *p->buf++ = (char)c;
+        for (i = 0; i < len && p->len + 1 < p->size; i++)
+                p->buf[p->len++] = buf[i];
         return 0;
 }
 
+struct printf_sink console_sink = { console_sink_write, NULL };
+struct printf_sink serial_sink = { serial_sink_write, NULL };
+struct printf_sink log_sink = { log_sink_write, NULL };
+
+void
+printf_mem_sink (struct printf_sink *sink, struct printf_mem *mem, char *buf,
+                 size_t size)
+{
+        mem->buf = buf;
+        mem->size = size;
+        mem->len = 0;
+        sink->write = mem_sink_write;
+        sink->data = mem;
+}
+
+int
+vsink_printf (struct printf_sink *sink, const char *format, va_list ap)
+{
+        struct printf_out out;
+        int r;
+
+        out.len = 0;
+        out.sink = sink;
+        r = do_printf (format, ap, &out);
+        flush_out (&out);
+        return r;
+}
+
+int
+sink_printf (struct printf_sink *sink, const char *format, ...)
+{
+        va_list ap;
+        int r;
+
+        va_start (ap, format);
+        r = vsink_printf (sink, format, ap);
+        va_end (ap);
+        return r;
+}
+
+int
+vsink_printf_compiled (struct printf_sink *sink,
+                       const struct printf_format *fmt, va_list ap)
+{
+        struct printf_out out;
+        va_list args;
+        int r;
+
+        out.len = 0;
+        out.sink = sink;
+        va_copy (args, ap);
+        r = do_printf_compiled (fmt, &args, &out);
+        va_end (args);
+        flush_out (&out);
+        return r;
+}
+
+int
+printf_compiled (const struct printf_format *fmt, ...)
+{
+        va_list ap;
+        int r;
+
+        va_start (ap, fmt);
+        r = vsink_printf_compiled (&console_sink, fmt, ap);
+        va_end (ap);
+        return r;
+}
+
 int
 printf (const char *format, ...)
 {
@@ -558,9 +806,7 @@ printf (const char *format, ...)
 int
 vprintf (const char *format, va_list ap)
 {
-        int r;
-        r = do_printf (format, ap, do_putchar, NULL);
-        return r;
+        return vsink_printf (&console_sink, format, ap);
 }
 
 int
@@ -578,12 +824,144 @@ snprintf (char *str, size_t size, const char *format, ...)
 int
 vsnprintf (char *str, size_t size, const char *format, va_list ap)
 {
-        struct snputchar_data data;
+        struct printf_sink sink;
+        struct printf_mem mem;
         int r;
 
-        data.buf = str;
-        data.len = size;
-        r = do_printf (format, ap, do_snputchar, &data);
-        do_snputchar ('\0', &data);
+        printf_mem_sink (&sink, &mem, str, size);
+        r = vsink_printf (&sink, format, ap);
+        if (size)
+                str[mem.len] = '\0';
         return r;
 }
+
+/* Benchmarks of integer conversion against the subtraction tables it
+   replaced. Those are kept here only as the reference. */
+
+static const unsigned long long sub10[] = {
+        10000000000000000000ULL,
+        1000000000000000000ULL,
+        100000000000000000ULL,
+        10000000000000000ULL,
+        1000000000000000ULL,
+        100000000000000ULL,
+        10000000000000ULL,
+        1000000000000ULL,
+        100000000000ULL,
+        10000000000ULL,
+        1000000000ULL,
+        100000000ULL,
+        10000000ULL,
+        1000000ULL,
+        100000ULL,
+        10000ULL,
+        1000ULL,
+        100ULL,
+        10ULL,
+        1ULL,
+        0ULL,
+};
+
+static const unsigned long long sub16[] = {
+        0x1000000000000000ULL,
+        0x100000000000000ULL,
+        0x10000000000000ULL,
+        0x1000000000000ULL,
+        0x100000000000ULL,
+        0x10000000000ULL,
+        0x1000000000ULL,
+        0x100000000ULL,
+        0x10000000ULL,
+        0x1000000ULL,
+        0x100000ULL,
+        0x10000ULL,
+        0x1000ULL,
+        0x100ULL,
+        0x10ULL,
+        0x1ULL,
+        0x0ULL,
+};
+
+static int
+valconv_sub (unsigned long long val, char *buf, const unsigned long long *sub,
+             const char *str)
+{
+        int n = 0;
+        int digit;
+
+        if (val == 0) {
+                *buf++ = '0';
+                return 1;
+        }
+        while (val < *sub)
+                sub++;
+        while (*sub) {
+                digit = 0;
+                while (val >= *sub) {
+                        digit++;
+                        val -= *sub;
+                }
+                *buf++ = str[digit];
+                n++;
+                sub++;
+        }
+        return n;
+}
+
+struct conv_bench {
+        const unsigned long long *vals;
+        int count;
+        int f;
+        const unsigned long long *sub;
+};
+
+static const unsigned long long conv_u32[] = {
+        7, 65535, 1234567, 4294967295ULL
+};
+static const unsigned long long conv_u64[] = {
+        123456789012ULL, 18446744073709551615ULL
+};
+static const unsigned long long conv_hex[] = {
+        0xdeadbeefULL, 0x123456789abcdefULL
+};
+
+static struct conv_bench conv_benches[] = {
+        { conv_u32, 4, CONVERSION_DECIMAL, sub10 },
+        { conv_u64, 2, CONVERSION_DECIMAL, sub10 },
+        { conv_hex, 2, CONVERSION_HEXADECIMAL, sub16 },
+};
+
+static void
+bench_conv (void *arg)
+{
+        struct conv_bench *b = arg;
+        char buf[32];
+        int i;
+
+        for (i = 0; i < b->count; i++)
+                valconv (b->vals[i], buf, b->f);
+}
+
+static void
+bench_conv_sub (void *arg)
+{
+        struct conv_bench *b = arg;
+        char buf[32];
+        int i;
+
+        for (i = 0; i < b->count; i++)
+                valconv_sub (b->vals[i], buf, b->sub, "0123456789abcdef");
+}
+
+/* Registers conv_* benchmarks of integer conversion alone, each next to
+   its conv_*_sub reference. */
+void
+printf_bench_register (void)
+{
+        bench_register ("conv_u32", bench_conv, &conv_benches[0], 64);
+        bench_register ("conv_u32_sub", bench_conv_sub, &conv_benches[0], 64);
+        bench_register ("conv_u64", bench_conv, &conv_benches[1], 64);
+        bench_register ("conv_u64_sub", bench_conv_sub, &conv_benches[1], 64);
+        bench_register ("conv_hex", bench_conv, &conv_benches[2], 64);
+        bench_register ("conv_hex_sub", bench_conv_sub, &conv_benches[2], 64);
+}
@@ -3,6 +3,9 @@
  */
  
 #include "screen.h"
+#include "memory.h"
+#include "string.h"
+#include "fb.h"
 
 /* color definitions */
 #define BLACK         0x0
@@ -17,79 +20,446 @@
 #define MAX_ROW       VGA_HEIGHT
 #define VRAM_SIZE     (MAX_COL*MAX_ROW)
 #define DEF_VRAM_BASE 0xb8000
+#define TEXT_ROWS     204       /* lines fitting in 32 KiB of text memory */
 
-/* from 'cursor.h' */
-extern int cursor_x;
-extern int cursor_y;
+/* where putchar and puts write to */
+static int console_targets = CONSOLE_VGA;
 
-#define PUT(c) ( ((unsigned short *) (DEF_VRAM_BASE)) \
-    [(cursor_y * MAX_COL) + cursor_x] = (FG_COLOR << 8 | (BG_COLOR << 12)) | (c))
+/*
+ * Every console keeps its cells in RAM, except the shown one while
+ * unbuffered, which writes straight to VRAM. In buffered mode
+ * the shown console's buffer is the back buffer: screen_present copies
+ * to VRAM only cells differing from 'shadow', which mirrors VRAM.
+ * So consoles in background are written at RAM speed, and switching
+ * consoles in buffered mode is a pointer change and one present.
+ */
+static unsigned short console_bufs[NR_CONSOLES][VRAM_SIZE];
+static struct console consoles[NR_CONSOLES] = {
+    { (unsigned short*)DEF_VRAM_BASE, console_bufs[0], 0, 0 },
+    { console_bufs[1], console_bufs[1], 0, 0 },
+    { console_bufs[2], console_bufs[2], 0, 0 },
+    { console_bufs[3], console_bufs[3], 0, 0 },
+};
+struct console* cur_console = &consoles[0];
+struct console* shown_console = &consoles[0];
+static unsigned short shadow[VRAM_SIZE];
+static char buffered = 0;
+/*
+ * Visible window starts at cell 'origin' of text memory.
+ * Screen scrolls by moving window down one line and telling CRTC
+ * its new start address. Only when window reaches the end of text
+ * memory, it is copied back to the start.
+ */
+static int origin = 0;
+
+#define VRAM_BYTES    (VRAM_SIZE * sizeof(unsigned short))
+#define ATTR (FG_COLOR << 8 | (BG_COLOR << 12))
+#define PUT(c) ( cur_console->cells[(cur_console->y * MAX_COL) + cur_console->x] = ATTR | (c))
+
+/*
+ * Scrollback ring keeps lines scrolled off the top of screen, chars only.
+ * A line is copied into it once, when it leaves the screen, so writers pay
+ * nothing per char. Only lines of the shown console are kept. While
+ * history is viewed, output goes to RAM and VRAM shows the view.
+ */
+static char* sb_lines = NULL;
+static int sb_size = 0;     /* capacity in lines */
+static int sb_count = 0;    /* lines stored */
+static int sb_next = 0;     /* slot of the next line */
+static int sb_view = 0;     /* how many lines view is above live screen */
+
+static unsigned short* vram_window() {
+    return (unsigned short*)DEF_VRAM_BASE + origin;
+}
+
+/*
+ * Makes CRTC show text memory from cell 'start'.
+ */
+static void set_origin(int start) {
+    origin = start;
+    outb(0x0C, 0x3D4);
+    outb((unsigned char) ((start >> 8) & 0xFF), 0x3D5);
+    outb(0x0D, 0x3D4);
+    outb((unsigned char) (start & 0xFF), 0x3D5);
+    cursor_set_origin(start);
+    if (! buffered) {
+        shown_console->cells = vram_window();
+    }
+}
+
+static void clear_row(unsigned short* row) {
+    memset16(row, ATTR | ' ', MAX_COL);
+}
+
+/*
+ * Appends screen line 'row' to scrollback ring.
+ */
+static void scrollback_push(unsigned short* row) {
+    char* line;
+    if (sb_size == 0) {
+        return;
+    }
+    line = &sb_lines[sb_next * MAX_COL];
+    for (int i = 0; i < MAX_COL; i++) {
+        line[i] = (char)row[i];
+    }
+    if (++sb_next == sb_size) {
+        sb_next = 0;
+    }
+    if (sb_count < sb_size) {
+        sb_count++;
+    }
+    /* keep viewed lines in place */
+    if (sb_view > 0 && sb_view < sb_count) {
+        sb_view++;
+    }
+}
+
+/*
+ * Scrolls screen one line up, bottom line becomes empty.
+ */
+static void cons_scroll() {
+    struct console* c = cur_console;
+    if (c == shown_console) {
+        scrollback_push(c->cells);
+    }
+    if (c->cells == c->buf) {
+        memmove(c->buf, c->buf + MAX_COL, (VRAM_SIZE - MAX_COL) * sizeof(*c->buf));
+    } else if (origin + VRAM_SIZE + MAX_COL > TEXT_ROWS * MAX_COL) {
+        unsigned short* vram = (unsigned short*)DEF_VRAM_BASE;
+        unsigned short* window = vram_window();
+        memmove(vram, window + MAX_COL, (VRAM_SIZE - MAX_COL) * sizeof(*vram));
+        set_origin(0);
+    } else {
+        set_origin(origin + MAX_COL);
+    }
+    clear_row(&c->cells[(MAX_ROW - 1) * MAX_COL]);
+}
+
+/*
+ * Moves cursor one line down, scrolling at the bottom.
+ */
+static void cons_linefeed() {
+    if (cur_console->y + 1 < MAX_ROW) {
+        cur_console->y += 1;
+    } else {
+        cons_scroll();
+    }
+}
+
+/*
+ * Moves cursor to the start of the next line.
+ */
+static void cons_newline() {
+    cur_console->x = 0;
+    cons_linefeed();
+}
 
 static void cons_putc(int c) {
     switch (c) {
     case '\t':
         do {
             cons_putc(' ');
-        } while ((cursor_x % 4) != 0);
+        } while ((cur_console->x % 4) != 0);
         break;
     case '\r':
-        cursor_x = 0;
+        cur_console->x = 0;
         break;
     case '\n':
-        cursor_y += 1;
-        if (cursor_y >= MAX_ROW) {
-            cursor_y = 0;
-        }
+        cons_linefeed();
         break;
     case '\b':
-        if (cursor_x > 0) {
-            cursor_x -= 1;
+        if (cur_console->x > 0) {
+            cur_console->x -= 1;
             PUT(' ');
         }
         break;
     default:
         PUT(c);
-        cursor_x += 1;
-        if (cursor_x >= MAX_COL) {
-            cursor_x = 0;
-            cursor_y += 1;
-            if (cursor_y >= MAX_ROW) {
-                cursor_y = 0;
-            }
+        cur_console->x += 1;
+        if (cur_console->x >= MAX_COL) {
+            cons_newline();
         }
     };
 }
 
+/*
+ * Writes 'n' printable chars from 's' at cursor, not crossing line end.
+ * Cells are stored in pairs by 32-bit writes.
+ */
+static void cons_write_run(const unsigned char* s, int n) {
+    unsigned short* p = &cur_console->cells[(cur_console->y * MAX_COL) + cur_console->x];
+    cur_console->x += n;
+    if (((unsigned int)p & 2) && n > 0) {
+        *p++ = ATTR | *s++;
+        n--;
+    }
+    for (; n >= 2; n -= 2, s += 2, p += 2) {
+        *(unsigned int*)p = (ATTR | s[0]) | ((ATTR | s[1]) << 16);
+    }
+    if (n > 0) {
+        *p = ATTR | *s;
+    }
+    if (cur_console->x >= MAX_COL) {
+        cons_newline();
+    }
+}
+
 static void _putchar(int c) {
     if (c == '\n') 
         cons_putc('\r');
     cons_putc(c);
 }
 
-void putchar(int c) {
-    _putchar(c);
+static void serial_putc(int c) {
+    if (c == '\n')
+        serial_putchar('\r');
+    serial_putchar(c);
+}
+
+/*
+ * Writes 'len' chars from 'buf' to screen. Runs of printable chars
+ * are copied in a tight loop, control chars go through cons_putc.
+ * Hardware cursor is synced once.
+ */
+static void vga_write(const char* buf, size_t len) {
+    const unsigned char* s = (const unsigned char*)buf;
+    const unsigned char* end = s + len;
+    while (s < end) {
+        const unsigned char* run = s;
+        int room = MAX_COL - cur_console->x;
+        while (s < end && s - run < room && *s >= ' ') {
+            s++;
+        }
+        if (s > run) {
+            cons_write_run(run, s - run);
+            continue;
+        }
+        _putchar(*s++);
+    }
     update_cursor();
 }
 
+/*
+ * Writes 'len' chars from 'buf' to all console targets.
+ */
+void console_write(const char* buf, size_t len) {
+    if (console_targets & CONSOLE_VGA) {
+        vga_write(buf, len);
+    }
+    if (console_targets & CONSOLE_SERIAL) {
+        for (size_t i = 0; i < len; i++) {
+            serial_putc(buf[i]);
+        }
+    }
+}
+
+/*
+ * Selects where console output goes, 'targets' is a mask of CONSOLE_* flags.
+ */
+void console_set_targets(int targets) {
+    console_targets = targets;
+}
+
+void putchar(int c) {
+    char ch = c;
+    console_write(&ch, 1);
+}
+
 int puts(const char* s) {
-    char c;
-    int i = -1;
-    while ((c = s[++i]) != '\0') {
-        _putchar(c);
+    int i = 0;
+    while (s[i] != '\0') {
+        i++;
     }
-    update_cursor();
+    console_write(s, i);
     return i;
 }
 
+/*
+ * Turns buffered mode on or off. While it is on, output reaches the screen
+ * and hardware cursor only on screen_present. When text is drawn to
+ * framebuffer, turning it off only presents the back buffer.
+ */
+void screen_set_buffered(int on) {
+    unsigned short* vram = vram_window();
+    if (on == buffered) {
+        return;
+    }
+    scrollback_live();
+    if (on) {
+        memcpy(shown_console->buf, vram, VRAM_BYTES);
+        memcpy(shadow, vram, VRAM_BYTES);
+        shown_console->cells = shown_console->buf;
+    } else {
+        screen_present();
+        if (fb_active) {
+            return;
+        }
+        shown_console->cells = vram;
+    }
+    buffered = on;
+    cursor_defer(on);
+}
+
+/*
+ * Copies changed cells of back buffer to VRAM, in runs of adjacent
+ * changed cells, and syncs hardware cursor.
+ */
+void screen_present() {
+    unsigned short* vram = vram_window();
+    unsigned short* backbuf = shown_console->buf;
+    int i = 0;
+    if (! buffered || sb_view > 0) {
+        return;
+    }
+    while (i < VRAM_SIZE) {
+        int start = i;
+        if (backbuf[i] == shadow[i]) {
+            i++;
+            continue;
+        }
+        do {
+            shadow[i] = backbuf[i];
+            i++;
+        } while (i < VRAM_SIZE && backbuf[i] != shadow[i]);
+        if (fb_active) {
+            fb_text_cells(start, i - start, &backbuf[start]);
+        } else {
+            memcpy(&vram[start], &backbuf[start], (i - start) * sizeof(*vram));
+        }
+    }
+    if (fb_active) {
+        fb_present();
+    }
+    cursor_sync();
+}
+
+/*
+ * Allocates scrollback ring of 'lines' lines. Without it,
+ * lines scrolled off the screen are lost.
+ */
+void scrollback_init(int lines) {
+    sb_lines = malloc(lines * MAX_COL);
+    sb_size = sb_lines != NULL ? lines : 0;
+    sb_count = sb_next = sb_view = 0;
+}
+
+/*
+ * Draws 25 lines starting 'sb_view' lines above live screen.
+ * Live screen lines are taken from RAM buffer of the shown console.
+ */
+static void scrollback_render() {
+    static unsigned short view[VRAM_SIZE];
+    int first = sb_count - sb_view;
+    for (int r = 0; r < MAX_ROW; r++) {
+        int line = first + r;
+        if (line < sb_count) {
+            char* src = &sb_lines[((sb_next - sb_count + line + sb_size) % sb_size) * MAX_COL];
+            for (int i = 0; i < MAX_COL; i++) {
+                view[r * MAX_COL + i] = ATTR | (unsigned char)src[i];
+            }
+        } else {
+            memcpy(&view[r * MAX_COL], &shown_console->buf[(line - sb_count) * MAX_COL],
+                   MAX_COL * sizeof(*view));
+        }
+    }
+    if (fb_active) {
+        fb_text_cells(0, VRAM_SIZE, view);
+        fb_present();
+    } else {
+        memcpy(vram_window(), view, sizeof(view));
+    }
+}
+
+/*
+ * Moves scrollback view 'pages' screens up (positive) or down (negative).
+ * Moving down past the live screen returns to it.
+ */
+void scrollback_page(int pages) {
+    int view = sb_view + pages * (MAX_ROW - 1);
+    if (view > sb_count) {
+        view = sb_count;
+    }
+    if (view <= 0) {
+        scrollback_live();
+        return;
+    }
+    if (view == sb_view) {
+        return;
+    }
+    if (sb_view == 0 && ! buffered) {
+        /* freeze live screen, output goes to RAM meanwhile */
+        memcpy(shown_console->buf, vram_window(), VRAM_BYTES);
+        shown_console->cells = shown_console->buf;
+    }
+    sb_view = view;
+    scrollback_render();
+}
+
+/*
+ * Leaves scrollback view and shows live screen again.
+ */
+void scrollback_live() {
+    unsigned short* vram = vram_window();
+    if (sb_view == 0) {
+        return;
+    }
+    sb_view = 0;
+    if (buffered) {
+        /* VRAM holds the view, so every cell must be presented */
+        for (int i = 0; i < VRAM_SIZE; i++) {
+            shadow[i] = ~shown_console->buf[i];
+        }
+        screen_present();
+    } else {
+        memcpy(vram, shown_console->buf, VRAM_BYTES);
+        shown_console->cells = vram;
+    }
+}
+
+/*
+ * Makes console 'n' current: putchar, puts and move_cursor work on it
+ * from now on. Returns number of previously current console.
+ */
+int console_select(int n) {
+    int prev = cur_console - consoles;
+    if (n >= 0 && n < NR_CONSOLES) {
+        cur_console = &consoles[n];
+    }
+    return prev;
+}
+
+/*
+ * Shows console 'n' on screen.
+ */
+void console_show(int n) {
+    struct console* next;
+    unsigned short* vram;
+    if (n < 0 || n >= NR_CONSOLES || &consoles[n] == shown_console) {
+        return;
+    }
+    next = &consoles[n];
+    vram = vram_window();
+    scrollback_live();
+    if (! buffered) {
+        /* hidden console must live in RAM */
+        memcpy(shown_console->buf, vram, VRAM_BYTES);
+        shown_console->cells = shown_console->buf;
+        memcpy(vram, next->buf, VRAM_BYTES);
+        next->cells = vram;
+    }
+    shown_console = next;
+    if (buffered) {
+        screen_present();
+    } else {
+        cursor_sync();
+    }
+}
+
 void clear_screen() {
-    cursor_x = 0;
-    cursor_y = 0;
-    
-    for (int i = 0; i < VRAM_SIZE; i++)
-        cons_putc(' ');
+    for (int i = 0; i < MAX_ROW; i++)
+        clear_row(&cur_console->cells[i * MAX_COL]);
     
-    cursor_x = 0;
-    cursor_y = 0;
     move_cursor(0, 0);
 }
 
@@ -97,6 +467,7 @@ int getchar() {
     int c;
     for (;;) {
         if ((c = get_char()) > 0) {
+            scrollback_live();
             return c;
         }           
     }
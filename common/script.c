@@ -0,0 +1,191 @@
+/*
+ * Contains scripted key input for unattended runs.
+ *
+ * Script is text with one step per line: '<delay_ms> <key>', where delay
+ * is counted from the previous step and key is one of left, right, down,
+ * up, enter, esc. Key is pressed and released as scancodes fed to the
+ * keyboard decoder, like ones read from port 0x60. Step 'exit' waits
+ * until the game has taken all keys and presented one more frame, then
+ * prints frame and latency statistics and exits QEMU. Lines starting
+ * with '#' are comments.
+ *
+ * Script is taken from the first Multiboot module with 'script' option,
+ * or read from serial port while it plays with 'script=serial'.
+ * With 'script_fast' delays are ignored and steps are fed as fast as
+ * the game takes key events.
+ */
+
+#include "script.h"
+#include "cmdline.h"
+#include "frame.h"
+#include "keyboard.h"
+#include "latency.h"
+#include "memory.h"
+#include "serial.h"
+#include "string.h"
+#include "time.h"
+
+int script_active = 0;
+
+static char* text = NULL;
+static unsigned int len = 0, pos = 0;
+static char from_serial = 0;
+static char fast = 0;
+
+/* parsed step waiting for its time; 0 means none */
+static unsigned short step_code = 0;
+static unsigned long long step_tsc = 0;
+static unsigned long long last_tsc = 0;     /* time of the previous step */
+static char exit_drained = 0;       /* key queue was seen empty at exit */
+static unsigned int exit_frames;    /* frame count at that moment */
+
+#define STEP_EXIT 0xffff
+
+/* set 1 scancodes, 0xE0 prefixed ones have it in high byte */
+static const struct {
+    const char* name;
+    unsigned short code;
+} script_keys[] = {
+    { "left",  0xe04b },
+    { "right", 0xe04d },
+    { "down",  0xe050 },
+    { "up",    0xe048 },
+    { "enter", 0x001c },
+    { "esc",   0x0001 },
+    { "exit",  STEP_EXIT },
+};
+
+/*
+ * Takes script from Multiboot module or prepares buffer for serial port,
+ * depending on command line. Returns 1 if there is a script.
+ */
+int script_init(multiboot_info_t* mbd) {
+    char opt[8];
+    const char* v = cmdline_value("script", opt, sizeof(opt));
+    fast = cmdline_has("script_fast");
+    if (v != NULL && strcmp(v, "serial") == 0) {
+        text = malloc(SCRIPT_SERIAL_MAX);
+        from_serial = 1;
+    } else if (cmdline_has("script") && (mbd->flags & MULTIBOOT_INFO_MODS) && mbd->mods_count > 0) {
+        module_t* mod = (module_t*)mbd->mods_addr;
+        len = mod->mod_end - mod->mod_start;
+        text = malloc(len + 1);
+        if (text != NULL) {
+            memmove(text, (void*)mod->mod_start, len);
+            /* last line may lack newline */
+            text[len++] = '\n';
+        }
+    }
+    return text != NULL;
+}
+
+/*
+ * Starts playing script, delay of the first step counts from now.
+ */
+void script_start() {
+    if (text != NULL) {
+        last_tsc = rdtsc();
+        script_active = 1;
+    }
+}
+
+/*
+ * Parses lines until a step. Returns 0 if there is no complete line.
+ */
+static int script_parse() {
+    while (pos < len) {
+        char name[SCRIPT_NAME_MAX + 1];
+        unsigned int ms = 0, end = pos, n = 0;
+        while (end < len && text[end] != '\n') {
+            end++;
+        }
+        if (end == len) {
+            return 0;
+        }
+        while (pos < end && text[pos] == ' ') {
+            pos++;
+        }
+        if (pos == end || text[pos] == '#') {
+            pos = end + 1;
+            continue;
+        }
+        while (pos < end && text[pos] >= '0' && text[pos] <= '9') {
+            ms = ms * 10 + (text[pos++] - '0');
+        }
+        while (pos < end && text[pos] == ' ') {
+            pos++;
+        }
+        while (pos < end && n < SCRIPT_NAME_MAX && text[pos] != ' ' && text[pos] != '\r') {
+            name[n++] = text[pos++];
+        }
+        name[n] = '\0';
+        pos = end + 1;
+        for (int i = 0; i < sizeof(script_keys) / sizeof(script_keys[0]); i++) {
+            if (strcmp(name, script_keys[i].name) == 0) {
+                step_code = script_keys[i].code;
+                step_tsc = last_tsc + (unsigned long long)tsc_khz * ms;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Exits once every injected key event has been taken by the game and
+ * a frame after that has been presented, so reports cover all of them.
+ */
+static void script_exit() {
+    if (! exit_drained) {
+        if (key_queued() != 0) {
+            return;
+        }
+        exit_drained = 1;
+        exit_frames = frame_stats.frames;
+    }
+    if (frame_stats.frames == exit_frames) {
+        return;
+    }
+    frame_report();
+    latency_report();
+    serial_printf("SCRIPT done keys_dropped=%u\n", key_dropped);
+    serial_flush();
+    qemu_exit(0);
+}
+
+/*
+ * Feeds steps which are due to keyboard decoder. Called by key_poll.
+ */
+void script_poll() {
+    int c;
+    if (from_serial) {
+        while (len < SCRIPT_SERIAL_MAX && (c = serial_getchar()) >= 0) {
+            text[len++] = c;
+        }
+    }
+    for (;;) {
+        if (step_code == 0 && ! script_parse()) {
+            if (! from_serial) {
+                script_active = 0;
+            }
+            return;
+        }
+        if (fast ? key_queued() >= KEY_BATCH : rdtsc() < step_tsc) {
+            return;
+        }
+        if (step_code == STEP_EXIT) {
+            script_exit();
+            return;
+        }
+        if (step_code >> 8) {
+            key_inject(step_code >> 8);
+        }
+        key_inject(step_code & 0xff);
+        if (step_code >> 8) {
+            key_inject(step_code >> 8);
+        }
+        key_inject((step_code & 0xff) | 0x80);
+        step_code = 0;
+        last_tsc = fast ? rdtsc() : step_tsc;
+    }
+}
@@ -0,0 +1,234 @@
+/*
+ * Contains interrupt-driven COM1 serial port driver.
+ * 16550 FIFO is enabled. Writers only append to transmit ring,
+ * interrupt handler moves up to 16 bytes into FIFO per interrupt.
+ */
+
+#include "serial.h"
+#include "printf.h"
+
+#define COM1        0x3F8
+#define DATA        (COM1 + 0)  /* data, divisor low when DLAB set */
+#define IER         (COM1 + 1)  /* interrupt enable, divisor high */
+#define IIR         (COM1 + 2)  /* interrupt identification / FIFO control */
+#define LCR         (COM1 + 3)  /* line control */
+#define MCR         (COM1 + 4)  /* modem control */
+#define LSR         (COM1 + 5)  /* line status */
+#define SCRATCH     (COM1 + 7)
+
+#define IER_RX      0x01        /* received data available */
+#define IER_TX      0x02        /* transmitter holding register empty */
+#define LSR_DR      0x01        /* data ready */
+#define LSR_THRE    0x20        /* transmitter holding register empty */
+#define FIFO_SIZE   16
+
+#define BAUD_DIVISOR 1          /* 115200 baud */
+
+unsigned int serial_dropped = 0;
+
+static char present = 0;
+static volatile unsigned char ier = 0;
+
+/* rings: producer advances 'head', consumer advances 'tail' */
+static unsigned char txbuf[SERIAL_TX_SIZE];
+static volatile unsigned int txhead = 0, txtail = 0;
+static unsigned char rxbuf[SERIAL_RX_SIZE];
+static volatile unsigned int rxhead = 0, rxtail = 0;
+
+/*
+ * Moves as much of transmit ring into FIFO as it can hold.
+ * Disables transmit interrupt when ring is empty.
+ * Must be called with interrupts disabled.
+ */
+static void tx_fill() {
+    for (int i = 0; i < FIFO_SIZE && txtail != txhead; i++) {
+        outb(txbuf[txtail & (SERIAL_TX_SIZE - 1)], DATA);
+        txtail++;
+    }
+    if (txtail == txhead) {
+        ier &= ~IER_TX;
+    } else {
+        ier |= IER_TX;
+    }
+    outb(ier, IER);
+}
+
+/*
+ * Starts transmission of ring contents if transmitter is idle.
+ */
+static void tx_kick() {
+    unsigned int flags;
+    if (! (ier & IER_TX)) {
+        flags = irq_save();
+        if (inb(LSR) & LSR_THRE) {
+            tx_fill();
+        } else {
+            ier |= IER_TX;
+            outb(ier, IER);
+        }
+        irq_restore(flags);
+    }
+}
+
+static void serial_irq(struct regs* r) {
+    unsigned char iir;
+    while (((iir = inb(IIR)) & 1) == 0) {
+        switch (iir & 0x0E) {
+        case 0x04:  /* received data */
+        case 0x0C:  /* receive timeout */
+            while (inb(LSR) & LSR_DR) {
+                unsigned char c = inb(DATA);
+                if (rxhead - rxtail < SERIAL_RX_SIZE) {
+                    rxbuf[rxhead & (SERIAL_RX_SIZE - 1)] = c;
+                    rxhead++;
+                }
+            }
+            break;
+        case 0x02:  /* transmitter empty */
+            tx_fill();
+            break;
+        case 0x06:  /* line status */
+            inb(LSR);
+            break;
+        default:    /* modem status */
+            inb(COM1 + 6);
+            break;
+        }
+    }
+}
+
+/*
+ * Initializes COM1 at 115200 8N1 with FIFO and interrupts enabled.
+ * Does nothing if there is no UART.
+ */
+void serial_init() {
+    outb(0x5A, SCRATCH);
+    if (inb(SCRATCH) != 0x5A) {
+        return;
+    }
+    outb(0x00, IER);
+    outb(0x80, LCR);            /* DLAB on */
+    outb(BAUD_DIVISOR & 0xFF, DATA);
+    outb(BAUD_DIVISOR >> 8, IER);
+    outb(0x03, LCR);            /* 8 bits, no parity, 1 stop bit */
+    outb(0xC7, IIR);            /* enable and clear FIFO, 14 byte threshold */
+    outb(0x0B, MCR);            /* DTR, RTS, OUT2 routes IRQ to PIC */
+    present = 1;
+    irq_install(IRQ_COM1, serial_irq);
+    ier = IER_RX;
+    outb(ier, IER);
+}
+
+int serial_present() {
+    return present;
+}
+
+/*
+ * Appends 'c' to transmit ring and never waits.
+ * If ring is full, char is dropped and counted in serial_dropped.
+ */
+void serial_putchar(int c) {
+    if (! present) {
+        return;
+    }
+    if (txhead - txtail >= SERIAL_TX_SIZE) {
+        serial_dropped++;
+        return;
+    }
+    txbuf[txhead & (SERIAL_TX_SIZE - 1)] = c;
+    txhead++;
+    tx_kick();
+}
+
+/*
+ * Like serial_putchar, but waits for room in transmit ring
+ * instead of dropping. For output which must not be lost.
+ */
+void serial_putchar_sync(int c) {
+    unsigned int flags;
+    if (! present) {
+        return;
+    }
+    while (txhead - txtail >= SERIAL_TX_SIZE) {
+        flags = irq_save();
+        if (inb(LSR) & LSR_THRE) {
+            tx_fill();
+        }
+        irq_restore(flags);
+    }
+    serial_putchar(c);
+}
+
+/*
+ * Appends 'len' chars from 'buf' to transmit ring, translating '\n'
+ * to "\r\n". Waits for room like serial_putchar_sync, but transmitter
+ * is kicked once for the whole block.
+ */
+void serial_write(const char* buf, size_t len) {
+    unsigned int flags;
+    if (! present) {
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        int crlf = buf[i] == '\n';
+        while (txhead - txtail + crlf >= SERIAL_TX_SIZE) {
+            flags = irq_save();
+            if (inb(LSR) & LSR_THRE) {
+                tx_fill();
+            }
+            irq_restore(flags);
+        }
+        if (crlf) {
+            txbuf[txhead & (SERIAL_TX_SIZE - 1)] = '\r';
+            txhead++;
+        }
+        txbuf[txhead & (SERIAL_TX_SIZE - 1)] = buf[i];
+        txhead++;
+    }
+    tx_kick();
+}
+
+/*
+ * Waits until transmit ring and FIFO are empty.
+ */
+void serial_flush() {
+    unsigned int flags;
+    if (! present) {
+        return;
+    }
+    while (txtail != txhead) {
+        flags = irq_save();
+        if (inb(LSR) & LSR_THRE) {
+            tx_fill();
+        }
+        irq_restore(flags);
+    }
+    while (! (inb(LSR) & 0x40)) {
+        /* wait for transmitter to become idle */
+    }
+}
+
+/*
+ * Prints formatted string to serial port, never losing output.
+ */
+int serial_printf(const char* format, ...) {
+    va_list ap;
+    int r;
+    va_start(ap, format);
+    r = vsink_printf(&serial_sink, format, ap);
+    va_end(ap);
+    return r;
+}
+
+/*
+ * Returns next received char or -1 if there is none.
+ */
+int serial_getchar() {
+    int c;
+    if (rxtail == rxhead) {
+        return -1;
+    }
+    c = rxbuf[rxtail & (SERIAL_RX_SIZE - 1)];
+    rxtail++;
+    return c;
+}
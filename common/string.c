@@ -0,0 +1,397 @@
+/*
+ * Contains memory block and string functions.
+ *
+ * memset, memcpy and memmove have several variants:
+ * - rep: rep stosd / rep movsd, then bytes; works on every CPU
+ * - erms: single rep stosb / rep movsb, fast with Enhanced REP MOVSB/STOSB
+ * - sse2: 64 bytes per iteration through xmm registers to aligned destination
+ * One of them is selected by string_init from CPUID feature bits.
+ * SSE2 is used only when fpu_init enabled SSE, otherwise
+ * the instructions fault.
+ */
+
+#include "string.h"
+#include "bench.h"
+#include "fpu.h"
+#include "memory.h"
+#include "printf.h"
+
+/* blocks smaller than this are copied by a plain loop */
+#define MEM_SMALL   16
+
+/* word-at-a-time helpers, 'x' has a zero byte when HAS_ZERO is not 0 */
+#define ONES        0x01010101u
+#define HIGHS       0x80808080u
+#define HAS_ZERO(x) (((x) - ONES) & ~(x) & HIGHS)
+
+typedef unsigned int __attribute__((may_alias)) word_t;
+
+static void* memset_rep(void* dst, int c, size_t n);
+static void* memcpy_rep(void* dst, const void* src, size_t n);
+
+static memset_fn_t memset_impl = memset_rep;
+static memcpy_fn_t memcpy_impl = memcpy_rep;
+static int has_sse2 = 0;
+static int has_erms = 0;
+
+static inline void cpuid(unsigned int leaf, unsigned int* a, unsigned int* b,
+                         unsigned int* c, unsigned int* d) {
+    __asm__ volatile ("cpuid" : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d) : "a"(leaf), "c"(0));
+}
+
+static void* memset_rep(void* dst, int c, size_t n) {
+    void* d = dst;
+    size_t words = n >> 2;
+    __asm__ volatile (
+        "rep stosl\n"
+        "movl %3, %%ecx\n"
+        "rep stosb\n"
+        : "+D"(d), "+c"(words)
+        : "a"((unsigned char)c * ONES), "r"(n & 3)
+        : "memory"
+    );
+    return dst;
+}
+
+static void* memset_erms(void* dst, int c, size_t n) {
+    void* d = dst;
+    __asm__ volatile ("rep stosb" : "+D"(d), "+c"(n) : "a"(c) : "memory");
+    return dst;
+}
+
+static void* memset_sse2(void* dst, int c, size_t n) {
+    char* d = dst;
+    size_t head = -(unsigned int)d & 15;
+    size_t blocks;
+    if (n < 64 + 16) {
+        return memset_rep(dst, c, n);
+    }
+    memset_rep(d, c, head);
+    d += head;
+    n -= head;
+    blocks = n >> 6;
+    __asm__ volatile (
+        "movd %2, %%xmm0\n"
+        "pshufd $0, %%xmm0, %%xmm0\n"
+        "1:\n"
+        "movdqa %%xmm0, (%0)\n"
+        "movdqa %%xmm0, 16(%0)\n"
+        "movdqa %%xmm0, 32(%0)\n"
+        "movdqa %%xmm0, 48(%0)\n"
+        "addl $64, %0\n"
+        "decl %1\n"
+        "jnz 1b\n"
+        : "+r"(d), "+r"(blocks)
+        : "r"((unsigned char)c * ONES)
+        : "memory", "xmm0"
+    );
+    memset_rep(d, c, n & 63);
+    return dst;
+}
+
+static void* memcpy_rep(void* dst, const void* src, size_t n) {
+    void* d = dst;
+    const void* s = src;
+    size_t words = n >> 2;
+    __asm__ volatile (
+        "rep movsl\n"
+        "movl %3, %%ecx\n"
+        "rep movsb\n"
+        : "+D"(d), "+S"(s), "+c"(words)
+        : "r"(n & 3)
+        : "memory"
+    );
+    return dst;
+}
+
+static void* memcpy_erms(void* dst, const void* src, size_t n) {
+    void* d = dst;
+    const void* s = src;
+    __asm__ volatile ("rep movsb" : "+D"(d), "+S"(s), "+c"(n) : : "memory");
+    return dst;
+}
+
+/*
+ * Source may be unaligned, so it is loaded with movdqu.
+ * All four loads of a block precede its stores, which keeps
+ * the copy correct for overlapping blocks with 'dst' below 'src'.
+ */
+static void* memcpy_sse2(void* dst, const void* src, size_t n) {
+    char* d = dst;
+    const char* s = src;
+    size_t head = -(unsigned int)d & 15;
+    size_t blocks;
+    if (n < 64 + 16) {
+        return memcpy_rep(dst, src, n);
+    }
+    memcpy_rep(d, s, head);
+    d += head;
+    s += head;
+    n -= head;
+    blocks = n >> 6;
+    __asm__ volatile (
+        "1:\n"
+        "movdqu (%1), %%xmm0\n"
+        "movdqu 16(%1), %%xmm1\n"
+        "movdqu 32(%1), %%xmm2\n"
+        "movdqu 48(%1), %%xmm3\n"
+        "movdqa %%xmm0, (%0)\n"
+        "movdqa %%xmm1, 16(%0)\n"
+        "movdqa %%xmm2, 32(%0)\n"
+        "movdqa %%xmm3, 48(%0)\n"
+        "addl $64, %1\n"
+        "addl $64, %0\n"
+        "decl %2\n"
+        "jnz 1b\n"
+        : "+r"(d), "+r"(s), "+r"(blocks)
+        :
+        : "memory", "xmm0", "xmm1", "xmm2", "xmm3"
+    );
+    memcpy_rep(d, s, n & 63);
+    return dst;
+}
+
+/*
+ * Copies backwards, for overlapping blocks with 'dst' above 'src'.
+ */
+static void* memcpy_backward(void* dst, const void* src, size_t n) {
+    char* d = (char*)dst + n - 1;
+    const char* s = (const char*)src + n - 1;
+    size_t bytes = n & 3;
+    __asm__ volatile (
+        "std\n"
+        "rep movsb\n"
+        "subl $3, %%edi\n"
+        "subl $3, %%esi\n"
+        "movl %3, %%ecx\n"
+        "rep movsl\n"
+        "cld\n"
+        : "+D"(d), "+S"(s), "+c"(bytes)
+        : "r"(n >> 2)
+        : "memory"
+    );
+    return dst;
+}
+
+/*
+ * Detects usable variants and selects the fastest of them.
+ * Should be called after fpu_init.
+ */
+void string_init() {
+    unsigned int a, b, c, d, max;
+    cpuid(0, &max, &b, &c, &d);
+    cpuid(1, &a, &b, &c, &d);
+    has_sse2 = (d & CPUID_EDX_SSE2) && fpu_sse;
+    if (max >= 7) {
+        cpuid(7, &a, &b, &c, &d);
+        has_erms = (b & CPUID_EBX_ERMS) != 0;
+    }
+    if (has_erms) {
+        memset_impl = memset_erms;
+        memcpy_impl = memcpy_erms;
+    } else if (has_sse2) {
+        memset_impl = memset_sse2;
+        memcpy_impl = memcpy_sse2;
+    } else {
+        memset_impl = memset_rep;
+        memcpy_impl = memcpy_rep;
+    }
+}
+
+void* memset(void* dst, int c, size_t n) {
+    if (n < MEM_SMALL) {
+        unsigned char* d = dst;
+        while (n--) {
+            *d++ = (unsigned char)c;
+        }
+        return dst;
+    }
+    return memset_impl(dst, c, n);
+}
+
+void* memcpy(void* dst, const void* src, size_t n) {
+    if (n < MEM_SMALL) {
+        unsigned char* d = dst;
+        const unsigned char* s = src;
+        while (n--) {
+            *d++ = *s++;
+        }
+        return dst;
+    }
+    return memcpy_impl(dst, src, n);
+}
+
+/*
+ * Copies forward unless 'dst' lies inside the source block.
+ */
+void* memmove(void* dst, const void* src, size_t n) {
+    if ((unsigned int)dst - (unsigned int)src >= n) {
+        return memcpy(dst, src, n);
+    }
+    return memcpy_backward(dst, src, n);
+}
+
+/*
+ * Fills 'count' 16-bit values, e.g. screen cells, with 'v'.
+ */
+void* memset16(void* dst, unsigned short v, size_t count) {
+    unsigned short* d = dst;
+    size_t words;
+    if ((unsigned int)d & 2 && count > 0) {
+        *d++ = v;
+        count--;
+    }
+    words = count >> 1;
+    __asm__ volatile (
+        "rep stosl\n"
+        : "+D"(d), "+c"(words)
+        : "a"(v | (unsigned int)v << 16)
+        : "memory"
+    );
+    if (count & 1) {
+        *d = v;
+    }
+    return dst;
+}
+
+size_t strlen(const char* s) {
+    const char* p = s;
+    const word_t* w;
+    while ((unsigned int)p & 3) {
+        if (*p == '\0') {
+            return p - s;
+        }
+        p++;
+    }
+    /* an aligned word never crosses a page, so reading past the end is safe */
+    for (w = (const word_t*)p; ! HAS_ZERO(*w); w++);
+    for (p = (const char*)w; *p != '\0'; p++);
+    return p - s;
+}
+
+void* memchr(const void* s, int c, size_t n) {
+    const unsigned char* p = s;
+    unsigned int mask = (unsigned char)c * ONES;
+    while (n > 0 && (unsigned int)p & 3) {
+        if (*p == (unsigned char)c) {
+            return (void*)p;
+        }
+        p++;
+        n--;
+    }
+    while (n >= 4 && ! HAS_ZERO(*(const word_t*)p ^ mask)) {
+        p += 4;
+        n -= 4;
+    }
+    for (; n > 0; p++, n--) {
+        if (*p == (unsigned char)c) {
+            return (void*)p;
+        }
+    }
+    return NULL;
+}
+
+int strcmp(const char* s1, const char* s2) {
+    if ((((unsigned int)s1 ^ (unsigned int)s2) & 3) == 0) {
+        const word_t *w1, *w2;
+        while ((unsigned int)s1 & 3) {
+            if (*s1 == '\0' || *s1 != *s2) {
+                return (unsigned char)*s1 - (unsigned char)*s2;
+            }
+            s1++;
+            s2++;
+        }
+        w1 = (const word_t*)s1;
+        w2 = (const word_t*)s2;
+        while (*w1 == *w2 && ! HAS_ZERO(*w1)) {
+            w1++;
+            w2++;
+        }
+        s1 = (const char*)w1;
+        s2 = (const char*)w2;
+    }
+    while (*s1 != '\0' && *s1 == *s2) {
+        s1++;
+        s2++;
+    }
+    return (unsigned char)*s1 - (unsigned char)*s2;
+}
+
+/* benchmarks of mem* variants over block sizes, to find crossovers */
+
+#define BENCH_BLOCK_MAX 65536
+
+struct mem_bench {
+    memset_fn_t set;
+    memcpy_fn_t cpy;
+    size_t size;
+};
+
+static const size_t bench_sizes[] = { 16, 128, 1024, 8192, BENCH_BLOCK_MAX };
+static struct mem_bench mem_benches[30];
+static char mem_bench_names[30][24];
+static char* bench_src;
+static char* bench_dst;
+
+static void bench_memset(void* arg) {
+    struct mem_bench* b = arg;
+    b->set(bench_dst, 0x55, b->size);
+}
+
+static void bench_memcpy(void* arg) {
+    struct mem_bench* b = arg;
+    b->cpy(bench_dst, bench_src, b->size);
+}
+
+/*
+ * Registers memset and memcpy benchmarks of every usable variant.
+ * string_init must be called before.
+ */
+void string_bench_register() {
+    struct {
+        const char* name;
+        memset_fn_t set;
+        memcpy_fn_t cpy;
+        int usable;
+    } variants[3];
+    int n = 0;
+
+    variants[0].name = "rep";
+    variants[0].set = memset_rep;
+    variants[0].cpy = memcpy_rep;
+    variants[0].usable = 1;
+    variants[1].name = "sse2";
+    variants[1].set = memset_sse2;
+    variants[1].cpy = memcpy_sse2;
+    variants[1].usable = has_sse2;
+    variants[2].name = "erms";
+    variants[2].set = memset_erms;
+    variants[2].cpy = memcpy_erms;
+    variants[2].usable = has_erms;
+
+    bench_src = malloc(BENCH_BLOCK_MAX);
+    bench_dst = malloc(BENCH_BLOCK_MAX);
+    if (bench_src == NULL || bench_dst == NULL) {
+        return;
+    }
+    memset(bench_src, 0xaa, BENCH_BLOCK_MAX);
+    for (int op = 0; op < 2; op++) {
+        for (int v = 0; v < 3; v++) {
+            if (! variants[v].usable) {
+                continue;
+            }
+            for (int i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++) {
+                struct mem_bench* mb = &mem_benches[n];
+                size_t size = bench_sizes[i];
+                mb->set = variants[v].set;
+                mb->cpy = variants[v].cpy;
+                mb->size = size;
+                snprintf(mem_bench_names[n], sizeof(mem_bench_names[n]), "%s_%s_%u",
+                         op == 0 ? "memset" : "memcpy", variants[v].name, size);
+                bench_register(mem_bench_names[n], op == 0 ? bench_memset : bench_memcpy,
+                               mb, size < 1024 ? 4096 / size : 4);
+                n++;
+            }
+        }
+    }
+}
@@ -24,6 +24,56 @@ void outb(unsigned char value, unsigned short int port) {
     );
 }
  
+/*
+ * Exits QEMU started with '-device isa-debug-exit,iobase=0xf4,iosize=0x04'.
+ * QEMU exit status becomes (code << 1) | 1. Halts if there is no such device.
+ */
+void qemu_exit(unsigned char code) {
+    outb(code, 0xf4);
+    for (;;) {
+        __asm__ volatile ("cli; hlt");
+    }
+}
+
+/*
+ * Divides 64-bit 'n' by 32-bit 'base' without libgcc helpers.
+ * Returns quotient and stores remainder to 'rem' if it is not NULL.
+ */
+unsigned long long udiv64(unsigned long long n, unsigned int base, unsigned int *rem) {
+    unsigned int high = (unsigned int)(n >> 32);
+    unsigned int low = (unsigned int)n;
+    unsigned int q_high = 0, r;
+    if (high >= base) {
+        q_high = high / base;
+        high %= base;
+    }
+    __asm__ (
+        "divl %4"
+        : "=a"(low), "=d"(r)
+        : "a"(low), "d"(high), "rm"(base)
+    );
+    if (rem != 0) {
+        *rem = r;
+    }
+    return ((unsigned long long)q_high << 32) | low;
+}
+
+/*
+ * Sorts 'n' unsigned ints ascending in place. Insertion sort,
+ * arrays are small and often nearly sorted.
+ */
+void sort_uint(unsigned int* a, int n) {
+    for (int i = 1; i < n; i++) {
+        unsigned int x = a[i];
+        int j = i - 1;
+        while (j >= 0 && a[j] > x) {
+            a[j + 1] = a[j];
+            j--;
+        }
+        a[j + 1] = x;
+    }
+}
+
 int rand() { 
     next = next * 1103515245 + 12345;
     return (unsigned int)(next / 65536) % 32768;    // RAND_MAX assumed to be 32767
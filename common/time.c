@@ -4,6 +4,8 @@
 
 #include "time.h"
 
+unsigned int tsc_khz = 0;
+
 static void delay_short(unsigned int x) {
 	const unsigned short TIME = 20000;
 	unsigned short t;
@@ -52,3 +54,36 @@ void sleeps(unsigned int seconds) {
 	}
 }
 
+
+/*
+ * Measures time stamp counter frequency against PIT.
+ * Takes about 75 ms. Polls keyboard, so key_init must be called first.
+ */
+void tsc_calibrate() {
+	const unsigned int TIME = 30000, TIMES = 3;
+	unsigned long long start = rdtsc();
+	for (unsigned int i = 0; i < TIMES; i++) {
+		delay_short(TIME);
+	}
+	tsc_khz = (unsigned int)udiv64((rdtsc() - start) * SECOND, TIME * TIMES * 1000, 0);
+}
+
+/*
+ * Converts 'cycles' of time stamp counter to nanoseconds.
+ */
+unsigned long long tsc_to_ns(unsigned long long cycles) {
+	if (tsc_khz == 0) {
+		return 0;
+	}
+	return udiv64(cycles * 1000000, tsc_khz, 0);
+}
+
+/*
+ * Converts 'cycles' of time stamp counter to microseconds.
+ */
+unsigned long long tsc_to_us(unsigned long long cycles) {
+	if (tsc_khz == 0) {
+		return 0;
+	}
+	return udiv64(cycles * 1000, tsc_khz, 0);
+}
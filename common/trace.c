@@ -0,0 +1,104 @@
+/*
+ * Contains function entry/exit tracing.
+ * Hooks are called by code compiled with -finstrument-functions,
+ * so nothing here may call instrumented functions.
+ */
+
+#include "trace.h"
+#include "printf.h"
+
+#define NO_TRACE __attribute__((no_instrument_function))
+
+/*
+ * Ring of trace records owned by one processor.
+ * Slot is reserved by atomic increment of 'head', so an interrupt
+ * handler may safely write records while interrupted code does.
+ * When ring is full, oldest records are overwritten.
+ */
+static struct trace_ring {
+    trace_rec_t recs[TRACE_RING_SIZE];
+    unsigned int head;          /* number of records ever written */
+} rings[NR_CPUS];
+
+static volatile char tracing = 0;
+static unsigned long long trace_base = 0;  /* time of trace_start */
+
+static NO_TRACE void trace_record(void* fn, unsigned short type) {
+    struct trace_ring* ring;
+    trace_rec_t* rec;
+    unsigned int cpu;
+    if (! tracing) {
+        return;
+    }
+    cpu = cpu_id();
+    ring = &rings[cpu];
+    rec = &ring->recs[__sync_fetch_and_add(&ring->head, 1) & (TRACE_RING_SIZE - 1)];
+    rec->tsc = rdtsc();
+    rec->fn = fn;
+    rec->cpu = cpu;
+    rec->type = type;
+}
+
+NO_TRACE void __cyg_profile_func_enter(void* fn, void* call_site) {
+    trace_record(fn, TRACE_ENTER);
+}
+
+NO_TRACE void __cyg_profile_func_exit(void* fn, void* call_site) {
+    trace_record(fn, TRACE_EXIT);
+}
+
+/*
+ * Clears all rings and starts recording.
+ */
+void trace_start() {
+    tracing = 0;
+    for (int i = 0; i < NR_CPUS; i++) {
+        rings[i].head = 0;
+    }
+    trace_base = rdtsc();
+    tracing = 1;
+}
+
+/*
+ * Stops recording. Recorded events are kept until next trace_start.
+ */
+void trace_stop() {
+    tracing = 0;
+}
+
+static void out_str(void (*out)(int c), const char* s) {
+    while (*s != '\0') {
+        out(*s++);
+    }
+}
+
+/*
+ * Writes recorded events as Chrome trace-event JSON char by char to 'out'.
+ * Function names are addresses, tools/trace_symbolize.py turns them
+ * into symbols from bin/kernel.bin.
+ * Recording is stopped, since 'out' is instrumented itself.
+ */
+void trace_export(void (*out)(int c)) {
+    char buf[96];
+    char first = 1;
+    trace_stop();
+    out_str(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        struct trace_ring* ring = &rings[cpu];
+        unsigned int start = 0;
+        if (ring->head > TRACE_RING_SIZE) {
+            start = ring->head - TRACE_RING_SIZE;
+        }
+        for (unsigned int i = start; i < ring->head; i++) {
+            trace_rec_t* rec = &ring->recs[i & (TRACE_RING_SIZE - 1)];
+            unsigned int ns;
+            unsigned long long us = udiv64(tsc_to_ns(rec->tsc - trace_base), 1000, &ns);
+            snprintf(buf, sizeof(buf), "%s{\"name\":\"%p\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":0,\"tid\":%u}",
+                     first ? "" : ",\n", rec->fn, rec->type == TRACE_ENTER ? 'B' : 'E',
+                     us, ns, rec->cpu);
+            out_str(out, buf);
+            first = 0;
+        }
+    }
+    out_str(out, "\n]}\n");
+}
@@ -0,0 +1,21 @@
+/*
+ * Contains in-kernel microbenchmark registry and runner.
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include "types.h"
+#include "sys.h"
+
+#define BENCH_MAX     96    /* max number of registered benchmarks */
+#define BENCH_WARMUP  3     /* repetitions thrown away before measuring */
+#define BENCH_REPS    31    /* measured repetitions */
+
+typedef void (*bench_fn_t)(void* arg);
+
+void bench_init();
+void bench_register(const char* name, bench_fn_t fn, void* arg, unsigned int iters);
+void bench_run_all();
+
+#endif
@@ -0,0 +1,17 @@
+/*
+ * Contains boot phase timestamps and startup latency report.
+ */
+
+#ifndef _BOOT_H
+#define _BOOT_H
+
+#include "sys.h"
+
+#define BOOT_MAX_PHASES 24
+
+extern unsigned long long boot_tsc; /* set by 'loader.s' at entry */
+
+void boot_mark(const char* phase);
+void boot_report();
+
+#endif
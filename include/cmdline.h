@@ -0,0 +1,16 @@
+/*
+ * Contains access to kernel command line passed by bootloader.
+ */
+
+#ifndef _CMDLINE_H
+#define _CMDLINE_H
+
+#include "multiboot.h"
+#include "types.h"
+
+void cmdline_init(multiboot_info_t* mbd); /* should be called from main */
+int cmdline_has(const char* option);
+const char* cmdline_value(const char* key, char* buf, size_t size);
+int cmdline_int(const char* key, int def);
+
+#endif
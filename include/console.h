@@ -0,0 +1,25 @@
+/*
+ * Contains virtual console state.
+ */
+
+#ifndef _CONSOLE_H
+#define _CONSOLE_H
+
+#define NR_CONSOLES 4   /* switched with Alt+F1 .. Alt+F4 */
+
+/*
+ * Text screen of one virtual console with its own cursor.
+ */
+struct console {
+    unsigned short* cells;  /* where chars are written: 'buf', or VRAM while shown unbuffered */
+    unsigned short* buf;    /* cells kept in RAM */
+    int x, y;               /* cursor position */
+};
+
+extern struct console* cur_console;     /* written by putchar, moved by move_cursor */
+extern struct console* shown_console;   /* on screen */
+
+int console_select(int n);
+void console_show(int n);
+
+#endif
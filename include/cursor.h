@@ -6,12 +6,15 @@
 #define _CURSOR_H
 
 #include "sys.h"
-
-int cursor_x, cursor_y;
+#include "console.h"
 
 void disable_cursor();
 void enable_cursor(unsigned short int cursor_start, unsigned short int cursor_end);
 void move_cursor(int x, int y);
+void move_cursor_delta(int delta_x, int delta_y);
 void update_cursor();
+void cursor_defer(int deferred);
+void cursor_sync();
+void cursor_set_origin(int cell);
 
 #endif
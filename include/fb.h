@@ -0,0 +1,26 @@
+/*
+ * Contains linear framebuffer graphics functions.
+ */
+
+#ifndef _FB_H
+#define _FB_H
+
+#include "multiboot.h"
+#include "types.h"
+
+#define FB_DIRTY_MAX  16    /* dirty rectangles kept before merging all */
+
+extern int fb_active;       /* whether text console is drawn to framebuffer */
+extern unsigned int fb_width, fb_height;
+
+int fb_init(multiboot_info_t* mbd); /* should be called from main after mem_init */
+unsigned int fb_rgb(unsigned char r, unsigned char g, unsigned char b);
+void fb_fill_rect(int x, int y, int w, int h, unsigned int color);
+void fb_blit(int x, int y, int w, int h, const unsigned int* src, int src_pitch);
+void fb_draw_char(int x, int y, unsigned char c, unsigned int fg, unsigned int bg);
+void fb_text_cells(int cell, int count, const unsigned short* src);
+void fb_present();
+
+void fb_bench_register();
+
+#endif
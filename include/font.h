@@ -0,0 +1,13 @@
+/*
+ * Contains 8x8 bitmap font of ASCII chars.
+ */
+
+#ifndef _FONT_H
+#define _FONT_H
+
+#define FONT_CHARS   128    /* chars 0-127, control chars are blank */
+#define FONT_HEIGHT  8      /* rows of 8 pixels, most significant bit left */
+
+extern const unsigned char font8x8[FONT_CHARS][FONT_HEIGHT];
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * Contains FPU/SSE initialization and lazy FPU context switching.
+ */
+
+#ifndef _FPU_H
+#define _FPU_H
+
+#include "sys.h"
+#include "types.h"
+
+#define CR0_MP         (1 << 1)     /* monitor coprocessor, wait/fwait honour TS */
+#define CR0_EM         (1 << 2)     /* emulation, FPU instructions fault */
+#define CR0_TS         (1 << 3)     /* task switched, next FPU instruction raises #NM */
+#define CR0_NE         (1 << 5)     /* native FPU error reporting */
+#define CR4_OSFXSR     (1 << 9)     /* OS supports fxsave/fxrstor and SSE */
+#define CR4_OSXMMEXCPT (1 << 10)    /* OS handles SIMD exceptions (#XM) */
+
+#define CPUID_EDX_FPU  (1 << 0)
+#define CPUID_EDX_FXSR (1 << 24)
+#define CPUID_EDX_SSE  (1 << 25)
+
+#define VECTOR_NM      7            /* device not available */
+
+/*
+ * Saved FPU/SSE registers of one execution context.
+ * fxsave needs 512 bytes aligned to 16, fnsave uses the first 108.
+ */
+struct fpu_ctx {
+    unsigned char area[512];
+    int used;                       /* whether registers were ever loaded */
+} __attribute__((aligned(16)));
+
+extern int fpu_sse;                 /* whether SSE instructions may be used */
+extern unsigned int fpu_restores;   /* context loads done by #NM handler */
+
+void fpu_init(); /* should be called from main after interrupts_init */
+void fpu_ctx_init(struct fpu_ctx* ctx);
+void fpu_switch(struct fpu_ctx* next);
+
+#endif
@@ -0,0 +1,27 @@
+/*
+ * Contains frame pacing and frame time statistics.
+ */
+
+#ifndef _FRAME_H
+#define _FRAME_H
+
+#include "sys.h"
+
+#define FRAME_FPS      60       /* default target frame rate */
+#define VGA_STATUS     0x3DA    /* VGA input status register 1 */
+#define VGA_VRETRACE   0x08     /* vertical retrace in progress */
+
+struct frame_stats {
+    unsigned int frames;        /* frames measured */
+    unsigned int missed;        /* frames later than 1.5 periods */
+    unsigned long long min, max, sum;   /* frame times in cycles */
+};
+
+extern struct frame_stats frame_stats;
+
+void frame_init(unsigned int fps); /* should be called after tsc_calibrate */
+unsigned long long frame_wait();
+void frame_resync();
+void frame_report();
+
+#endif
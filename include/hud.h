@@ -0,0 +1,30 @@
+/*
+ * Contains frame time and input latency overlay drawn over the game.
+ */
+
+#ifndef _HUD_H
+#define _HUD_H
+
+#include "sys.h"
+
+#define HUD_WINDOW     128  /* frames frame time statistics are taken over */
+#define HUD_REFRESH    15   /* frames between overlay redraws */
+#define HUD_LATENCIES  4    /* latest key latencies shown */
+
+/* measured parts of a frame */
+enum HudSpan {
+    HUD_KEY_WORK,
+    HUD_GAME_UPDATE,
+    HUD_VIDEO_UPDATE,
+    HUD_SPANS,
+};
+
+extern int hud_enabled;
+
+void hud_init(int enabled);
+void hud_frame(unsigned long long cycles);
+void hud_span(int span, unsigned long long cycles);
+void hud_latency(unsigned long long cycles);
+void hud_draw();
+
+#endif
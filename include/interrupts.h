@@ -0,0 +1,55 @@
+/*
+ * Contains descriptor tables, PIC and interrupt handling functions.
+ */
+
+#ifndef _INTERRUPTS_H
+#define _INTERRUPTS_H
+
+#include "sys.h"
+
+#define IRQ_BASE   32   /* vector of IRQ 0 after PIC remapping */
+#define NUM_IRQS   16
+#define NUM_ISRS   (IRQ_BASE + NUM_IRQS)
+
+/* hardware interrupt lines */
+#define IRQ_TIMER    0
+#define IRQ_KEYBOARD 1
+#define IRQ_COM2     3
+#define IRQ_COM1     4
+
+/*
+ * Registers saved by 'isr_common' from 'interrupts.s'.
+ */
+struct regs {
+    unsigned int edi, esi, ebp, esp, ebx, edx, ecx, eax;
+    unsigned int vector, error;
+    unsigned int eip, cs, eflags;
+};
+
+typedef void (*isr_handler_t)(struct regs* r);
+
+void interrupts_init(); /* should be called from main before drivers */
+void isr_install(int vector, isr_handler_t handler);
+void irq_install(int irq, isr_handler_t handler);
+void irq_unmask(int irq);
+void irq_mask(int irq);
+
+/*
+ * Disables interrupts and returns previous EFLAGS for irq_restore.
+ */
+static inline __attribute__((no_instrument_function))
+unsigned int irq_save() {
+    unsigned int flags;
+    __asm__ volatile ("pushfl; popl %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+/*
+ * Restores interrupt flag saved by irq_save.
+ */
+static inline __attribute__((no_instrument_function))
+void irq_restore(unsigned int flags) {
+    __asm__ volatile ("pushl %0; popfl" : : "r"(flags) : "memory", "cc");
+}
+
+#endif
@@ -7,7 +7,7 @@
 #include "sys.h"
 #include "memory.h"
 
-/* key codes */ 
+/* key codes; keys of printable chars have code of their char without shift */ 
 enum KeyCode {
     UNKNOWN,
     ARROW_UP,
@@ -16,12 +16,57 @@ enum KeyCode {
     ARROW_RIGHT,
     ENTER,
     ESCAPE,
+    PAGE_UP,
+    PAGE_DOWN,
+    KEY_BACKSPACE,
+    KEY_TAB,
+    KEY_LSHIFT,
+    KEY_RSHIFT,
+    KEY_CTRL,
+    KEY_ALT,
+    KEY_CAPS,
+    KEY_F1,
+    KEY_F12 = KEY_F1 + 11,
+    KEY_PRINTABLE = 0x20,
+    KEY_MAX = 0x80,
 };
 
+/* modifier state bits */
+#define KEY_MOD_LSHIFT 0x01
+#define KEY_MOD_RSHIFT 0x02
+#define KEY_MOD_SHIFT  (KEY_MOD_LSHIFT | KEY_MOD_RSHIFT)
+#define KEY_MOD_CAPS   0x04     /* caps lock is on */
+#define KEY_MOD_CTRL   0x08
+#define KEY_MOD_ALT    0x10
+
+#define KEY_EVENTS_SIZE 256  /* event ring size, power of 2 */
+#define KEY_BATCH       32   /* events taken per frame by the game */
+
+/* key event flags */
+#define KEY_EV_DOWN   0x1
+#define KEY_EV_REPEAT 0x2    /* typematic repeat of a key already down */
+
+/*
+ * One key event, stamped when its scancode was polled.
+ */
+struct key_event {
+    unsigned long long tsc;  /* time stamp counter at arrival */
+    unsigned char key;       /* enum KeyCode */
+    unsigned char mods;      /* KEY_MOD_* bits after the event */
+    unsigned char flags;     /* KEY_EV_* bits */
+};
+
+extern unsigned char key_mods;  /* current KEY_MOD_* bits */
+extern unsigned int key_dropped; /* events lost because of full ring */
+
 void key_buffer_clear();
 void key_init();
 void key_poll();
+void key_inject(unsigned char c);
+unsigned int key_queued();
 void key_decode(int *key, char *pressed);
+int key_events(struct key_event* evs, int max);
+int key_down(int key);
 int get_char();
 
 #endif
@@ -0,0 +1,25 @@
+/*
+ * Contains input-to-photon latency histogram.
+ */
+
+#ifndef _LATENCY_H
+#define _LATENCY_H
+
+#include "sys.h"
+
+#define LATENCY_BUCKET_US 100   /* histogram bucket width */
+#define LATENCY_BUCKETS   512   /* last bucket also takes longer latencies */
+
+/* percentiles in microseconds, upper bounds of their buckets */
+struct latency_stats {
+    unsigned int count;
+    unsigned int p50, p90, p99;
+    unsigned int max;           /* exact */
+};
+
+void latency_reset();
+void latency_record(unsigned long long cycles);
+void latency_get(struct latency_stats* s);
+void latency_report();
+
+#endif
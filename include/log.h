@@ -0,0 +1,37 @@
+/*
+ * Contains in-memory kernel log and deferred binary logging.
+ */
+
+#ifndef _LOG_H
+#define _LOG_H
+
+#include "types.h"
+#include "sys.h"
+
+#define LOG_SIZE      8192  /* text ring size, power of 2 */
+#define LOG_RING_SIZE 1024  /* binary records per processor, power of 2 */
+#define LOG_ARGS_MAX  6     /* argument words kept per record */
+#define LOG_DRAIN_MAX 16    /* records formatted per frame by the game loop */
+
+/*
+ * One binary log record of 36 bytes. Arguments are raw 32-bit words,
+ * 'long long' takes two of them.
+ */
+typedef struct log_rec {
+    unsigned long long tsc;     /* time stamp counter at event */
+    const char* format;         /* NULL while record is written */
+    unsigned int args[LOG_ARGS_MAX];
+} log_rec_t;
+
+struct printf_sink;
+
+extern unsigned int log_lost;   /* records overwritten before drained */
+
+void log_init(const char* out); /* should be called after tsc_calibrate */
+void log_write(const char* buf, size_t len);
+int log_printf(const char* format, ...);
+void log_event(const char* format, ...);
+int log_drain(int max);
+void log_dump();
+
+#endif
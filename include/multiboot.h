@@ -97,8 +97,39 @@ typedef struct multiboot_info
  } u;
  unsigned long mmap_length;
  unsigned long mmap_addr;
+ unsigned long drives_length;
+ unsigned long drives_addr;
+ unsigned long config_table;
+ unsigned long boot_loader_name;
+ unsigned long apm_table;
+ unsigned long vbe_control_info;
+ unsigned long vbe_mode_info;
+ unsigned short vbe_mode;
+ unsigned short vbe_interface_seg;
+ unsigned short vbe_interface_off;
+ unsigned short vbe_interface_len;
+ unsigned long long framebuffer_addr;
+ unsigned long framebuffer_pitch;
+ unsigned long framebuffer_width;
+ unsigned long framebuffer_height;
+ unsigned char framebuffer_bpp;
+ unsigned char framebuffer_type;
+ /* color info for direct RGB framebuffer */
+ unsigned char framebuffer_red_field_position;
+ unsigned char framebuffer_red_mask_size;
+ unsigned char framebuffer_green_field_position;
+ unsigned char framebuffer_green_mask_size;
+ unsigned char framebuffer_blue_field_position;
+ unsigned char framebuffer_blue_mask_size;
 } multiboot_info_t;
 
+/* Bits of 'flags' in multiboot_info. */
+#define MULTIBOOT_INFO_MODS             0x00000008
+#define MULTIBOOT_INFO_FRAMEBUFFER      0x00001000
+
+/* Values of 'framebuffer_type'. */
+#define MULTIBOOT_FRAMEBUFFER_TYPE_RGB  1
+
 /* The module structure. */
 typedef struct module
 {
@@ -9,6 +9,59 @@
 #include "stdarg.h"
 #include "screen.h"
 
+#define PRINTF_BUF_SIZE 128     /* output is passed to sinks in chunks of it */
+
+/* Output sink: 'write' gets buffered output when buffer is full and
+   when printing ends. Negative return stops printing. */
+struct printf_sink {
+        int (*write)(const char *buf, size_t len, void *data);
+        void *data;
+};
+
+/* state of a memory buffer sink, output beyond 'size' - 1 is dropped */
+struct printf_mem {
+        char *buf;
+        size_t size;
+        size_t len;
+};
+
+#define PRINTF_SPECS_MAX  8     /* conversions in a compiled format */
+#define PRINTF_CACHE_SIZE 32    /* compiled formats cached, power of 2 */
+
+/* literal text followed by a parsed conversion */
+struct printf_spec {
+        const char *lit;
+        int litlen;
+        int f;
+        int width;
+        int precision;
+};
+
+/* Format split by printf_compile. It points into 'format', which must
+   stay unchanged while compiled form is used. */
+struct printf_format {
+        const char *format;
+        int nspecs;
+        struct printf_spec specs[PRINTF_SPECS_MAX];
+};
+
+extern struct printf_sink console_sink;
+extern struct printf_sink serial_sink;
+extern struct printf_sink log_sink;
+
+void printf_mem_sink (struct printf_sink *sink, struct printf_mem *mem,
+                      char *buf, size_t size);
+int sink_printf (struct printf_sink *sink, const char *format, ...);
+int vsink_printf (struct printf_sink *sink, const char *format, va_list ap);
+int printf_compile (struct printf_format *fmt, const char *format);
+int printf_compiled (const struct printf_format *fmt, ...);
+int vsink_printf_compiled (struct printf_sink *sink,
+                           const struct printf_format *fmt, va_list ap);
 int printf (const char *format, ...); 
+int vprintf (const char *format, va_list ap);
+int snprintf (char *str, size_t size, const char *format, ...);
+int vsnprintf (char *str, size_t size, const char *format, va_list ap);
+
+void printf_bench_register (void);
 
 #endif
@@ -9,7 +9,19 @@
 #include "sys.h"
 #include "cursor.h"
 #include "keyboard.h"
+#include "serial.h"
 
+/* console output targets */
+#define CONSOLE_VGA    0x1
+#define CONSOLE_SERIAL 0x2
+
+void console_set_targets(int targets);
+void console_write(const char* buf, size_t len);
+void screen_set_buffered(int buffered);
+void screen_present();
+void scrollback_init(int lines);
+void scrollback_page(int pages);
+void scrollback_live();
 void clear_screen();
 void putchar(int c);
 int puts(const char* s);
@@ -0,0 +1,20 @@
+/*
+ * Contains scripted key input for unattended runs.
+ */
+
+#ifndef _SCRIPT_H
+#define _SCRIPT_H
+
+#include "multiboot.h"
+#include "types.h"
+
+#define SCRIPT_SERIAL_MAX 16384 /* script text buffered from serial port */
+#define SCRIPT_NAME_MAX   8     /* longest key name */
+
+extern int script_active;
+
+int script_init(multiboot_info_t* mbd); /* should be called after cmdline_init */
+void script_start();
+void script_poll();
+
+#endif
@@ -0,0 +1,26 @@
+/*
+ * Contains interrupt-driven COM1 serial port driver.
+ */
+
+#ifndef _SERIAL_H
+#define _SERIAL_H
+
+#include "types.h"
+#include "sys.h"
+#include "interrupts.h"
+
+#define SERIAL_TX_SIZE 4096  /* transmit ring size, power of 2 */
+#define SERIAL_RX_SIZE 256   /* receive ring size, power of 2 */
+
+extern unsigned int serial_dropped; /* chars lost because of full ring */
+
+void serial_init(); /* should be called after interrupts_init */
+int serial_present();
+void serial_putchar(int c);
+void serial_putchar_sync(int c);
+void serial_write(const char* buf, size_t len);
+void serial_flush();
+int serial_printf(const char* format, ...);
+int serial_getchar();
+
+#endif
@@ -0,0 +1,30 @@
+/*
+ * Contains memory block and string functions.
+ */
+
+#ifndef _STRING_H
+#define _STRING_H
+
+#include "types.h"
+
+/* CPUID feature bits used for dispatch */
+#define CPUID_EDX_SSE2     (1 << 26)
+#define CPUID_EBX_ERMS     (1 << 9)     /* leaf 7 */
+
+typedef void* (*memset_fn_t)(void* dst, int c, size_t n);
+typedef void* (*memcpy_fn_t)(void* dst, const void* src, size_t n);
+
+void string_init(); /* selects mem* variants, should be called from main */
+
+void* memset(void* dst, int c, size_t n);
+void* memcpy(void* dst, const void* src, size_t n);
+void* memmove(void* dst, const void* src, size_t n);
+void* memset16(void* dst, unsigned short v, size_t count);
+
+size_t strlen(const char* s);
+void* memchr(const void* s, int c, size_t n);
+int strcmp(const char* s1, const char* s2);
+
+void string_bench_register();
+
+#endif
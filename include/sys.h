@@ -8,6 +8,28 @@
 #define VGA_WIDTH 80
 #define VGA_HEIGHT 25
 
+/* only the bootstrap processor runs kernel code */
+#define NR_CPUS 1
+
+/*
+ * Reads time stamp counter. Is inline and never instrumented,
+ * so it may be called from tracing hooks.
+ */
+static inline __attribute__((no_instrument_function))
+unsigned long long rdtsc() {
+    unsigned long long t;
+    __asm__ volatile ("rdtsc" : "=A"(t));
+    return t;
+}
+
+/*
+ * Returns number of the current processor.
+ */
+static inline __attribute__((no_instrument_function))
+unsigned int cpu_id() {
+    return 0;
+}
+
 void outb(unsigned char value, unsigned short int port);
 unsigned char inb(unsigned short int port);
 
@@ -15,4 +37,8 @@ int rand();
 void srand(unsigned int seed);
 void rtc_seed();
 
+void qemu_exit(unsigned char code);
+unsigned long long udiv64(unsigned long long n, unsigned int base, unsigned int *rem);
+void sort_uint(unsigned int* a, int n);
+
 #endif
@@ -10,7 +10,13 @@
 
 #define SECOND 1193182  /* 1 second ~ 1193182 ticks */
 
+extern unsigned int tsc_khz; /* time stamp counter frequency */
+
 void delay(unsigned int ticks);
 void sleeps(unsigned int seconds);
 
+void tsc_calibrate(); /* should be called after key_init */
+unsigned long long tsc_to_ns(unsigned long long cycles);
+unsigned long long tsc_to_us(unsigned long long cycles);
+
 #endif
@@ -0,0 +1,33 @@
+/*
+ * Contains function entry/exit tracing.
+ * Works only in kernel built with 'make TRACE=1', which compiles
+ * sources with -finstrument-functions.
+ */
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include "sys.h"
+#include "time.h"
+
+#define TRACE_RING_SIZE 16384   /* records per processor, power of 2 */
+
+/* record types */
+#define TRACE_ENTER 0
+#define TRACE_EXIT  1
+
+/*
+ * One trace record of 16 bytes.
+ */
+typedef struct trace_rec {
+    unsigned long long tsc;     /* time stamp counter at event */
+    void* fn;                   /* address of traced function */
+    unsigned short cpu;         /* processor the event happened on */
+    unsigned short type;        /* TRACE_ENTER or TRACE_EXIT */
+} trace_rec_t;
+
+void trace_start();
+void trace_stop();
+void trace_export(void (*out)(int c));
+
+#endif
@@ -0,0 +1,49 @@
+    .text
+    .global isr_table                # entry points of all handled vectors
+
+# stub for vector without error code, pushes dummy one
+    .macro ISR_NOERR num
+isr\num:
+    pushl $0
+    pushl $\num
+    jmp   isr_common
+    .endm
+
+# stub for vector which has error code pushed by processor
+    .macro ISR_ERR num
+isr\num:
+    pushl $\num
+    jmp   isr_common
+    .endm
+
+    .irp num, 0,1,2,3,4,5,6,7,9,15,16,18,19,20,22,23,24,25,26,27,28,31
+    ISR_NOERR \num
+    .endr
+    .irp num, 8,10,11,12,13,14,17,21,29,30
+    ISR_ERR \num
+    .endr
+    # hardware interrupts remapped to 32-47
+    .irp num, 32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47
+    ISR_NOERR \num
+    .endr
+
+# saves registers and passes them to C handler as 'struct regs'
+isr_common:
+    pusha
+    cld
+    pushl %esp                       # 'regs' arg to isr_dispatch
+    call  isr_dispatch
+    addl  $4, %esp
+    popa
+    addl  $8, %esp                   # drop vector and error code
+    iret
+
+    .data
+    .align 4
+isr_table:
+    .irp num, 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31
+    .long isr\num
+    .endr
+    .irp num, 32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47
+    .long isr\num
+    .endr
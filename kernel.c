@@ -27,81 +27,184 @@
 #include "cursor.h"
 #include "time.h"
 #include "keyboard.h"
+#include "interrupts.h"
+#include "serial.h"
+#include "cmdline.h"
+#include "bench.h"
+#include "boot.h"
+#include "string.h"
+#include "fpu.h"
+#include "fb.h"
+#include "frame.h"
+#include "hud.h"
+#include "log.h"
+#include "latency.h"
+#include "script.h"
+#ifdef TRACE
+#include "trace.h"
+#endif
 
 /* game field size */
 #define FIELD_WIDTH 10
 #define FIELD_HEIGHT 20
 
+/* time between gravity falls of brick */
+#define GRAVITY_MS 1000
+
 /* ASCII chars used in game */
 #define BRICK_CHAR  '#'
 #define EMPTY_CHAR  ' '   
 #define OTHER_CHAR  '@'
 #define BORDER_CHAR '|'
 
+/* limits of brick definitions */
+#define NUM_BRICKS  7
+#define BRICK_CELLS 4
+#define BRICK_ROTS  4
+#define BRICK_KICKS 4
+
 /*
- * All possible bricks and their positions.
- * Suffix "_n" means rotated clockwise by n degrees.
+ * Shape of brick in one rotation: (x, y) offsets of its cells from
+ * top-left corner of its w by h bounding box.
  */
-#define NUM_POS 19
-#define NUM_BRICKS 7
- 
-enum BrickPos {
-    I,
-    I_90,
-    J,
-    J_90,
-    J_180,
-    J_270, // 5
-    L,
-    L_90,
-    L_180,
-    L_270,
-    O, 	// 10
-    S,
-    S_90,
-    T,
-    T_90,
-    T_180, // 15
-    T_270,
-    Z,
-    Z_90,
+struct BrickRot {
+    char cells[BRICK_CELLS][2];
+    char w, h;
 };
 
-char brick_types[NUM_BRICKS] = {I, J, L, O, S, T, Z};
+/*
+ * Definition of brick.
+ * rots: shapes rotated clockwise by 0, 90, ... degrees.
+ * spawn_x, spawn_y: position of new brick relative to middle of top
+ *                   of game field.
+ * kicks: (dx, dy) moves tried in order when rotating from each rotation,
+ *        the first one where rotated brick fits is taken.
+ */
+struct BrickDef {
+    char num_rots;
+    char spawn_x, spawn_y;
+    struct BrickRot rots[BRICK_ROTS];
+    char num_kicks;
+    char kicks[BRICK_ROTS][BRICK_KICKS][2];
+};
 
-/* width of each brick */
-char brick_widths[NUM_POS] = {1, 4, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2};
+/* rotate in place, else step aside from wall or brick */
+#define KICKS_SIDE {{0, 0}, {-1, 0}, {1, 0}}
+
+struct BrickDef bricks[NUM_BRICKS] = {
+    {   /* I */
+        2, 0, 0,
+        {
+            {{{0, 0}, {0, 1}, {0, 2}, {0, 3}}, 1, 4},
+            {{{0, 0}, {1, 0}, {2, 0}, {3, 0}}, 4, 1},
+        },
+        4, {
+            {{-1, 1}, {-2, 1}, {-3, 1}, {0, 1}},
+            {{1, -1}, {2, -1}, {0, -1}, {1, 0}},
+        },
+    },
+    {   /* J */
+        4, -1, 0,
+        {
+            {{{1, 0}, {1, 1}, {1, 2}, {0, 2}}, 2, 3},
+            {{{0, 0}, {0, 1}, {1, 1}, {2, 1}}, 3, 2},
+            {{{0, 0}, {1, 0}, {0, 1}, {0, 2}}, 2, 3},
+            {{{0, 0}, {1, 0}, {2, 0}, {2, 1}}, 3, 2},
+        },
+        3, {KICKS_SIDE, KICKS_SIDE, KICKS_SIDE, KICKS_SIDE},
+    },
+    {   /* L */
+        4, -1, 0,
+        {
+            {{{0, 0}, {0, 1}, {0, 2}, {1, 2}}, 2, 3},
+            {{{0, 0}, {1, 0}, {2, 0}, {0, 1}}, 3, 2},
+            {{{0, 0}, {1, 0}, {1, 1}, {1, 2}}, 2, 3},
+            {{{0, 1}, {1, 1}, {2, 1}, {2, 0}}, 3, 2},
+        },
+        3, {KICKS_SIDE, KICKS_SIDE, KICKS_SIDE, KICKS_SIDE},
+    },
+    {   /* O */
+        1, -1, 0,
+        {
+            {{{0, 0}, {1, 0}, {0, 1}, {1, 1}}, 2, 2},
+        },
+        0,
+    },
+    {   /* S */
+        2, -1, 0,
+        {
+            {{{1, 0}, {2, 0}, {0, 1}, {1, 1}}, 3, 2},
+            {{{0, 0}, {0, 1}, {1, 1}, {1, 2}}, 2, 3},
+        },
+        3, {KICKS_SIDE, KICKS_SIDE},
+    },
+    {   /* T */
+        4, -1, 0,
+        {
+            {{{0, 0}, {1, 0}, {2, 0}, {1, 1}}, 3, 2},
+            {{{1, 0}, {0, 1}, {1, 1}, {1, 2}}, 2, 3},
+            {{{1, 0}, {0, 1}, {1, 1}, {2, 1}}, 3, 2},
+            {{{0, 0}, {0, 1}, {1, 1}, {0, 2}}, 2, 3},
+        },
+        3, {KICKS_SIDE, KICKS_SIDE, KICKS_SIDE, KICKS_SIDE},
+    },
+    {   /* Z */
+        2, -1, 0,
+        {
+            {{{0, 0}, {1, 0}, {1, 1}, {2, 1}}, 3, 2},
+            {{{1, 0}, {0, 1}, {1, 1}, {0, 2}}, 2, 3},
+        },
+        3, {KICKS_SIDE, KICKS_SIDE},
+    },
+};
+
+/*
+ * Row masks of each brick rotation from top to bottom,
+ * bit 0 is the most left column of the brick. Built by bricks_init.
+ */
+unsigned short brick_rows[NUM_BRICKS][BRICK_ROTS][BRICK_CELLS];
+
+/* mask of a row with all columns occupied */
+#define FULL_ROW ((1 << FIELD_WIDTH) - 1)
 
 /*
  * Structure for current falling brick.
  * x, y: coordinates of most left and top char of the brick.
  * next_x, next_y: coordinates where brick is moving next. They may be
  *               applied in game_update function.
- * type: type and rotation of the current block.
+ * type, rot: index of the current block in bricks and its rotation.
+ * next_type: type of the block shown as next one.
  */
 struct Brick {
     int x, y;
     int next_x, next_y;
-    enum BrickPos type;
-    enum BrickPos next_type;
+    int type, rot;
+    int next_type;
 };
 
-/* game field */
-char **field;
+/*
+ * Game field of landed bricks, one mask per row, bit j set if column j
+ * is occupied. Falling brick is kept out of it until it lands.
+ */
+unsigned short field[FIELD_HEIGHT];
 /* current falling brick */
 struct Brick *brick;
-/* buttons pressed and not released */
-char arrow_left_pressed = 0;
-char arrow_right_pressed = 0;
-char arrow_down_pressed = 0;
-char arrow_up_pressed = 0;
-char enter_pressed = 0;
+/* arrival times of key events handled since the last presented frame */
+unsigned long long input_tags[KEY_BATCH];
+int num_input_tags = 0;
 /* number of completed and deleted rows */
 int rows_completed = 0;
+/* set until the first game frame is shown */
+char first_frame = 1;
+#ifdef TRACE
+/* number of frames left to trace before export */
+int trace_frames = 1;
+#endif
 
 
 void game_init();
 void game_run();
+void first_frame_done();
 char game_update();
 void game_end();
 
@@ -115,26 +218,78 @@ void pause_display();
 void key_work();
 
 void brick_gravity_fall();
+void brick_rotate();
 void brick_spawn();
 
-void draw_I(int x, int y, char c);
-void draw_I_90(int x, int y, char c);
-void draw_O(int x, int y, char c);
+void bricks_init();
+char brick_collides(int type, int rot, int x, int y);
+unsigned short brick_row(int row);
+void brick_place();
+void brick_preview(int type, int x, int y);
 
-void row_delete(int row);
 void rows_delete_completed();
 
+void game_bench_register();
+
 
 /*  
  * Entry point accessed from 'loader.s'. 
  */
 void main(multiboot_info_t* mbd, unsigned int magic) {   
+    char log_out[16];
+    int scripted;
     mem_init(mbd);
+    boot_mark("mem_init");
+    cmdline_init(mbd);
+    boot_mark("cmdline_init");
+    scripted = script_init(mbd);
+    scrollback_init(cmdline_int("scrollback", 500));
+    boot_mark("scrollback_init");
+    interrupts_init();
+    boot_mark("interrupts_init");
+    fpu_init();
+    boot_mark("fpu_init");
+    string_init();
+    boot_mark("string_init");
+    if (fb_init(mbd)) {
+        screen_set_buffered(1);
+    }
+    boot_mark("fb_init");
+    serial_init();
+    boot_mark("serial_init");
     key_init();
+    boot_mark("key_init");
+    tsc_calibrate();
+    boot_mark("tsc_calibrate");
+    log_init(cmdline_value("log", log_out, sizeof(log_out)));
+    boot_mark("log_init");
     rtc_seed();
+    if (scripted) {
+        /* scripted runs must be reproducible */
+        srand(cmdline_int("seed", 1));
+    }
+    boot_mark("rtc_seed");
     disable_cursor();
+    boot_mark("disable_cursor");
+    frame_init(cmdline_int("fps", FRAME_FPS));
+    boot_mark("frame_init");
+    hud_init(cmdline_has("hud"));
+    screen_set_buffered(1);
+    bricks_init();
+    if (cmdline_has("bench")) {
+        srand(1);
+        game_init();
+        bench_init();
+        game_bench_register();
+        bench_run_all();
+        qemu_exit(0);
+    }
+    script_start();
     for (;;) {
         game_init();
+        if (first_frame) {
+            boot_mark("game_init");
+        }
         game_run();
         game_end();
     }
@@ -146,13 +301,7 @@ void main(multiboot_info_t* mbd, unsigned int magic) {
 void game_init() {
     clear_screen();
     key_buffer_clear();
-    field = malloc(FIELD_WIDTH * sizeof(char*));
-    for (int i = 0; i < FIELD_WIDTH; i++) {
-        field[i] = malloc(FIELD_HEIGHT * sizeof(char));
-        for (int j = 0; j < FIELD_HEIGHT; j++) {
-            field[i][j] = EMPTY_CHAR;
-        }
-    }
+    memset(field, 0, sizeof(field));
     /* draw borders */
     for (int i = 0; i < FIELD_HEIGHT; i++) {
         /* left */
@@ -164,576 +313,117 @@ void game_init() {
     }
     /* set current falling brick */
     brick = malloc(sizeof(struct Brick));
-    brick->next_type = brick_types[(rand()) % NUM_BRICKS];
+    brick->next_type = rand() % NUM_BRICKS;
     brick_spawn();
 }
 
 /* 
  * Contains one game logic.
+ * Every frame handles keys and is presented at frame_wait pace,
+ * brick falls once per GRAVITY_MS.
  */
 void game_run() {   
     char done = 0;
+    unsigned long long fall_period = (unsigned long long)tsc_khz * GRAVITY_MS;
+    unsigned long long next_fall = rdtsc() + fall_period;
+    frame_resync();
     while (! done) {
-        for (int i = 0; i < 5; i++) {
-            key_work();
-            video_update();
-            delay(SECOND / 5);
-        }
-        brick_gravity_fall();
-        game_update();
+        char fall = 0;
+        unsigned long long t;
+        hud_frame(frame_wait());
+#ifdef TRACE
+        if (trace_frames > 0) {
+            trace_start();
+        }
+#endif
+        t = rdtsc();
+        key_work();
+        hud_span(HUD_KEY_WORK, rdtsc() - t);
+        if (rdtsc() >= next_fall) {
+            next_fall += fall_period;
+            if (next_fall < rdtsc()) {
+                /* after pause */
+                next_fall = rdtsc() + fall_period;
+            }
+            fall = 1;
+            brick_gravity_fall();
+            t = rdtsc();
+            game_update();
+            hud_span(HUD_GAME_UPDATE, rdtsc() - t);
+        }
+        /* overlay is drawn outside of measured spans, presented by video_update */
+        hud_draw();
+        t = rdtsc();
         video_update();
-        if (you_loose_check()) {
+        hud_span(HUD_VIDEO_UPDATE, rdtsc() - t);
+        /* the frame reflecting handled key events is on screen now */
+        t = rdtsc();
+        for (int i = 0; i < num_input_tags; i++) {
+            latency_record(t - input_tags[i]);
+            hud_latency(t - input_tags[i]);
+        }
+        num_input_tags = 0;
+        if (first_frame) {
+            first_frame_done();
+        }
+#ifdef TRACE
+        if (trace_frames > 0 && --trace_frames == 0) {
+            trace_export(serial_putchar_sync);
+            serial_flush();
+        }
+#endif
+        log_drain(LOG_DRAIN_MAX);
+        if (fall && you_loose_check()) {
             done = 1;
+            log_event("game over, score %d\n", rows_completed);
+            log_drain(LOG_RING_SIZE);
+            frame_report();
+            latency_report();
             gameover_display();
         }
     }
 }
 
+/*
+ * Reports boot time when the first frame is on screen.
+ * With 'bootexit' on command line, exits QEMU right after that.
+ */
+void first_frame_done() {
+    first_frame = 0;
+    boot_mark("first_frame");
+    boot_report();
+    if (cmdline_has("bootexit")) {
+        qemu_exit(0);
+    }
+}
+
 /*
  * Updates brick position to (next_x, next_y) if were no collisions.
- * Otherwise creates new brick.
- * Calls check for completed rows.
+ * Otherwise lands the brick, deletes completed rows and creates new brick.
  * Returns 1 if brick stuck else 0.
  */
 char game_update() {
-    /* delete brick at prev pos */
-    switch (brick->type) {
-    case O:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 2) {
-            brick->next_x = FIELD_WIDTH - 2;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x+1][brick->next_y] == OTHER_CHAR ||
-                    field[brick->next_x][brick->next_y+1] == OTHER_CHAR || 
-                        field[brick->next_x+1][brick->next_y+1] == OTHER_CHAR ||
-                    brick->next_y >= FIELD_HEIGHT - 1) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_O(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_O(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_O(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case I:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 1) {
-            brick->next_x = FIELD_WIDTH - 1;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x][brick->next_y+1] == OTHER_CHAR || 
-                    field[brick->next_x][brick->next_y+2] == OTHER_CHAR || 
-                        field[brick->next_x][brick->next_y+3] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 3) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_I(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_I(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_I(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case I_90:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 4) {
-            brick->next_x = FIELD_WIDTH - 4;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x+1][brick->next_y] == OTHER_CHAR || 
-                    field[brick->next_x+2][brick->next_y] == OTHER_CHAR || 
-                        field[brick->next_x+3][brick->next_y] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_I_90(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_I_90(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_I_90(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case J:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 2) {
-            brick->next_x = FIELD_WIDTH - 2;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x+1][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x+1][brick->next_y+1] == OTHER_CHAR || 
-                    field[brick->next_x+1][brick->next_y+2] == OTHER_CHAR || 
-                        field[brick->next_x][brick->next_y+2] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 2) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_J(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_J(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_J(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case J_90:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 3) {
-            brick->next_x = FIELD_WIDTH - 3;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x][brick->next_y+1] == OTHER_CHAR || 
-                    field[brick->next_x+1][brick->next_y+1] == OTHER_CHAR || 
-                        field[brick->next_x+2][brick->next_y+1] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 1) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_J_90(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_J_90(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_J_90(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case J_180:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 2) {
-            brick->next_x = FIELD_WIDTH - 2;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x+1][brick->next_y] == OTHER_CHAR || 
-                    field[brick->next_x][brick->next_y+1] == OTHER_CHAR || 
-                        field[brick->next_x][brick->next_y+2] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 2) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_J_180(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_J_180(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_J_180(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-     case J_270:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 3) {
-            brick->next_x = FIELD_WIDTH - 3;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x+1][brick->next_y] == OTHER_CHAR || 
-                    field[brick->next_x+2][brick->next_y] == OTHER_CHAR || 
-                        field[brick->next_x+2][brick->next_y+1] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 1) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_J_270(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_J_270(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_J_270(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case L:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 2) {
-            brick->next_x = FIELD_WIDTH - 2;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x][brick->next_y+1] == OTHER_CHAR || 
-                    field[brick->next_x][brick->next_y+2] == OTHER_CHAR || 
-                        field[brick->next_x+1][brick->next_y+2] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 2) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_L(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_L(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_L(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case L_90:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 3) {
-            brick->next_x = FIELD_WIDTH - 3;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x+1][brick->next_y] == OTHER_CHAR || 
-                    field[brick->next_x+2][brick->next_y] == OTHER_CHAR || 
-                        field[brick->next_x][brick->next_y+1] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 1) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_L_90(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_L_90(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_L_90(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case L_180:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 2) {
-            brick->next_x = FIELD_WIDTH - 2;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x+1][brick->next_y] == OTHER_CHAR || 
-                    field[brick->next_x+1][brick->next_y+1] == OTHER_CHAR || 
-                        field[brick->next_x+1][brick->next_y+2] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 2) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_L_180(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_L_180(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_L_180(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-     case L_270:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 3) {
-            brick->next_x = FIELD_WIDTH - 3;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y+1] == OTHER_CHAR || 
-                field[brick->next_x+1][brick->next_y+1] == OTHER_CHAR || 
-                    field[brick->next_x+2][brick->next_y+1] == OTHER_CHAR || 
-                        field[brick->next_x+2][brick->next_y] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 1) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_L_270(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_L_270(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_L_270(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case S:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 3) {
-            brick->next_x = FIELD_WIDTH - 3;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x+1][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x+2][brick->next_y] == OTHER_CHAR || 
-                    field[brick->next_x][brick->next_y+1] == OTHER_CHAR || 
-                        field[brick->next_x+1][brick->next_y+1] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 1) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_S(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_S(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_S(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case S_90:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 2) {
-            brick->next_x = FIELD_WIDTH - 2;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x][brick->next_y+1] == OTHER_CHAR || 
-                    field[brick->next_x+1][brick->next_y+1] == OTHER_CHAR || 
-                        field[brick->next_x+1][brick->next_y+2] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 2) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_S_90(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_S_90(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_S_90(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case Z:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 3) {
-            brick->next_x = FIELD_WIDTH - 3;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x+1][brick->next_y] == OTHER_CHAR || 
-                    field[brick->next_x+1][brick->next_y+1] == OTHER_CHAR || 
-                        field[brick->next_x+2][brick->next_y+1] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 1) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_Z(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_Z(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_Z(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case Z_90:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 2) {
-            brick->next_x = FIELD_WIDTH - 2;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x+1][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x][brick->next_y+1] == OTHER_CHAR || 
-                    field[brick->next_x+1][brick->next_y+1] == OTHER_CHAR || 
-                        field[brick->next_x][brick->next_y+2] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 2) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_Z_90(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_Z_90(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_Z_90(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case T:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 3) {
-            brick->next_x = FIELD_WIDTH - 3;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x+1][brick->next_y] == OTHER_CHAR || 
-                    field[brick->next_x+2][brick->next_y] == OTHER_CHAR || 
-                        field[brick->next_x+1][brick->next_y+1] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 1) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_T(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_T(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_T(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case T_90:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 2) {
-            brick->next_x = FIELD_WIDTH - 2;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x+1][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x][brick->next_y+1] == OTHER_CHAR || 
-                    field[brick->next_x+1][brick->next_y+1] == OTHER_CHAR || 
-                        field[brick->next_x+1][brick->next_y+2] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 2) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_T_90(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_T_90(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_T_90(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case T_180:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 3) {
-            brick->next_x = FIELD_WIDTH - 3;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x+1][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x][brick->next_y+1] == OTHER_CHAR || 
-                    field[brick->next_x+1][brick->next_y+1] == OTHER_CHAR || 
-                        field[brick->next_x+2][brick->next_y+1] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 1) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_T_180(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_T_180(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_T_180(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
-    case T_270:
-        /* check boundary */
-        if (brick->next_x > FIELD_WIDTH - 2) {
-            brick->next_x = FIELD_WIDTH - 2;
-        }
-        if (brick->next_x < 0) {
-            brick->next_x = 0;
-        }
-        /* collision */
-        if (field[brick->next_x][brick->next_y] == OTHER_CHAR || 
-                field[brick->next_x][brick->next_y+1] == OTHER_CHAR || 
-                    field[brick->next_x+1][brick->next_y+1] == OTHER_CHAR || 
-                        field[brick->next_x][brick->next_y+2] == OTHER_CHAR ||
-                            brick->next_y >= FIELD_HEIGHT - 2) 
-        {
-            if (brick->x != brick->next_x) {
-                brick->next_x = brick->x;
-                return 0;
-            }
-            draw_T_270(brick->x, brick->y, OTHER_CHAR);
-            brick_spawn();
-            return 1;
-        }
-        /* delete brick at prev pos */
-        draw_T_270(brick->x, brick->y, EMPTY_CHAR);
-        /* draw brick at next pos */
-        draw_T_270(brick->next_x, brick->next_y, BRICK_CHAR);
-        break;
+    /* check boundary */
+    int w = bricks[brick->type].rots[brick->rot].w;
+    if (brick->next_x > FIELD_WIDTH - w) {
+        brick->next_x = FIELD_WIDTH - w;
+    }
+    if (brick->next_x < 0) {
+        brick->next_x = 0;
+    }
+    /* collision */
+    if (brick_collides(brick->type, brick->rot, brick->next_x, brick->next_y)) {
+        if (brick->x != brick->next_x) {
+            brick->next_x = brick->x;
+            return 0;
+        }
+        brick_place();
+        rows_delete_completed();
+        brick_spawn();
+        return 1;
     }
     brick->x = brick->next_x;
     brick->y = brick->next_y;
-    rows_delete_completed();
     return 0;
 }
 
@@ -741,15 +431,7 @@ char game_update() {
  * Ends game and utilizes resources created by game_init.
  */
 void game_end() {
-    arrow_left_pressed = 0;
-    arrow_right_pressed = 0;
-    arrow_down_pressed = 0;
-    arrow_up_pressed = 0;
     rows_completed = 0;
-    for (int i = 0; i < FIELD_WIDTH; i++) {
-        free(field[i]);
-    }
-    free(field);
     free(brick);
 }
 
@@ -760,10 +442,20 @@ void game_end() {
 void video_update() {
 	/* show field */
     for (int i = 0; i < FIELD_HEIGHT; i++) {
-        move_cursor(VGA_WIDTH/2 - FIELD_WIDTH/2, VGA_HEIGHT/2 - FIELD_HEIGHT/2 + i);
+        char line[FIELD_WIDTH + 1];
+        unsigned short falling = brick_row(i);
         for (int j = 0; j < FIELD_WIDTH; j++) {
-            putchar(field[j][i]);
+            if (field[i] & (1 << j)) {
+                line[j] = OTHER_CHAR;
+            } else if (falling & (1 << j)) {
+                line[j] = BRICK_CHAR;
+            } else {
+                line[j] = EMPTY_CHAR;
+            }
         }
+        line[FIELD_WIDTH] = '\0';
+        move_cursor(VGA_WIDTH/2 - FIELD_WIDTH/2, VGA_HEIGHT/2 - FIELD_HEIGHT/2 + i);
+        puts(line);
     }
     /* borders */
     for (int i = 0; i < FIELD_HEIGHT; i++) {
@@ -775,7 +467,7 @@ void video_update() {
         putchar(BORDER_CHAR);
     }
     /* indicate where the brick will fall */
-    char len = brick_widths[brick->type];
+    char len = bricks[brick->type].rots[brick->rot].w;
     move_cursor(VGA_WIDTH/2 - FIELD_WIDTH/2, 22);
     puts("            ");
     move_cursor(brick->x + VGA_WIDTH/2 - FIELD_WIDTH/2, 22);
@@ -793,153 +485,7 @@ void video_update() {
 		puts("     ");
 		move_cursor_delta(-5, 1);
 	}
-	move_cursor(73, 3);
-    switch(brick->next_type) {
-	case I:
-		for (int i = 0; i < 4; i++) {
-			putchar(BRICK_CHAR);
-			move_cursor_delta(-1, 1);
-		}
-		break;
-	case I_90:
-		for (int i = 0; i < 4; i++) {
-			putchar(BRICK_CHAR);
-		}
-		break;
-	case J:
-		move_cursor_delta(0, 2);
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, -1);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, -1);
-		putchar(BRICK_CHAR);
-		break;
-	case J_90:
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, 1);
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		break;
-	case J_180:
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-2, 1);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, 1);
-		putchar(BRICK_CHAR);
-		break;
-	case J_270:
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, 1);
-		putchar(BRICK_CHAR);
-		break;	
-	case L:
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, 1);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, 1);
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		break;
-	case L_90:
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-3, 1);
-		putchar(BRICK_CHAR);
-		break;
-	case L_180:
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, 1);		
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, 1);
-		putchar(BRICK_CHAR);
-		break;
-	case L_270:
-		move_cursor_delta(0, 1);
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);		
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, -1);
-		putchar(BRICK_CHAR);
-		break;
-	case O:
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-2, 1);
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		break;
-	case S:
-		move_cursor_delta(1, 0);
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-3, 1);
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		break;
-	case S_90:
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, 1);
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, 1);
-		putchar(BRICK_CHAR);
-		break;
-	case T:
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);		
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-2, 1);
-		putchar(BRICK_CHAR);
-		break;
-	case T_90:
-		move_cursor_delta(0, 1);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-2, 1);
-		putchar(BRICK_CHAR);		
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, 1);
-		putchar(BRICK_CHAR);
-		break;
-	case T_180:
-		move_cursor_delta(0, 1);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-2, 1);
-		putchar(BRICK_CHAR);		
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		break;
-	case T_270:
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, 1);
-		putchar(BRICK_CHAR);		
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-2, 1);
-		putchar(BRICK_CHAR);
-		break;
-	case Z:
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-1, 1);				
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		break;
-	case Z_90:
-		move_cursor_delta(1, 0);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-2, 1);				
-		putchar(BRICK_CHAR);
-		putchar(BRICK_CHAR);
-		move_cursor_delta(-2, 1);				
-		putchar(BRICK_CHAR);
-		break;
-	}
+    brick_preview(brick->next_type, 73, 3);
     /* show hints */
     move_cursor(1, 21);
     puts("Arrows: move");
@@ -947,18 +493,14 @@ void video_update() {
     puts("Enter: rotate");
     move_cursor(1, 23);
     puts("Esc: pause");
+    screen_present();
 }
 
 /*
  * Checks if gamer looses.
  */
 char you_loose_check() {
-    for (int j = 0; j < FIELD_WIDTH; j++) {
-        if (field[j][0] == OTHER_CHAR) {
-            return 1;
-        }
-    }
-    return 0;
+    return field[0] != 0;
 }
 
 /*
@@ -970,6 +512,7 @@ void gameover_display() {
     printf("game over! you scored %d", rows_completed);
     move_cursor(25, 11);
     printf("press ENTER to start another game...");
+    screen_present();
     int k = 0;
     char pressed = 0;
     while (! (k == ENTER && pressed)) {
@@ -995,6 +538,7 @@ void pause_display() {
     puts("Enter: rotate");
     move_cursor(1, 23);
     puts("Esc: pause");
+    screen_present();
     int k = 0;
     char pressed = 0;
     while (! (k == ESCAPE && pressed)) {
@@ -1002,79 +546,55 @@ void pause_display() {
         delay(SECOND / 50);
     }
     clear_screen();
+    frame_resync();
 }
 
 /*
- * Keyboard "callback". After it completes, game_update is called.
+ * Keyboard "callback". Takes pending key events as one batch,
+ * game_update is called after each handled one, and arrival time of
+ * the event is kept in input_tags until its frame is presented.
  * Keys:
  * ESC - displays pause;
  * Arrow DOWN - moves falling brick one pos lower;
  * Arrow UP - move brick down immediately;
  * Arrow LEFT & Arrow RIGHT - moves brick left and right respectively;
  * Enter - rotates brick clockwise.
+ * Releases and typematic repeats are ignored.
  */
 void key_work() {
-    int k = -1;
-    char pressed;
-    while (k != UNKNOWN) {
-        key_decode(&k, &pressed);
-        if (k == ESCAPE) {
-            if (pressed) {
-                pause_display();
-            }
-        }
-        if (k == ARROW_DOWN) {
-            if (pressed) {
-                if (! arrow_down_pressed) {
-                    brick->next_y++;
-                    arrow_down_pressed = 1;
-                }
-            } else {
-                arrow_down_pressed = 0;
-            }
-        }
-        if (k == ARROW_LEFT) {
-            if (pressed) {
-                if (! arrow_left_pressed) {
-                    brick->next_x--;
-                    arrow_left_pressed = 1;
-                }
-            } else {
-                arrow_left_pressed = 0;
-            }
-        }
-        if (k == ARROW_RIGHT) {
-            if (pressed) {
-                if (! arrow_right_pressed) {
-                    brick->next_x++;
-                    arrow_right_pressed = 1;
-                }
-            } else {
-                arrow_right_pressed = 0;
-            }
-        }
-        if (k == ARROW_UP) {
-            if (pressed) {
-                if (! arrow_up_pressed) {
-                    do {
-                        brick->next_y++;
-                    } while (game_update() == 0);
-                    arrow_up_pressed = 1;
-                }
-            } else {
-                arrow_up_pressed = 0;
-            }
+    struct key_event evs[KEY_BATCH];
+    int n = key_events(evs, KEY_BATCH);
+    for (int i = 0; i < n; i++) {
+        if (evs[i].flags != KEY_EV_DOWN) {
+            continue;
         }
-        if (k == ENTER) {
-            if (pressed) {
-                if (! enter_pressed) {
-                    brick_rotate();
-                    enter_pressed = 1;
-                }
-            } else {
-                enter_pressed = 0;
-            }
+        switch (evs[i].key) {
+        case ESCAPE:
+            /* frames of earlier events weren't shown before pause */
+            pause_display();
+            num_input_tags = 0;
+            continue;
+        case ARROW_DOWN:
+            brick->next_y++;
+            break;
+        case ARROW_LEFT:
+            brick->next_x--;
+            break;
+        case ARROW_RIGHT:
+            brick->next_x++;
+            break;
+        case ARROW_UP:
+            do {
+                brick->next_y++;
+            } while (game_update() == 0);
+            break;
+        case ENTER:
+            brick_rotate();
+            break;
+        default:
+            continue;
         }
+        input_tags[num_input_tags++] = evs[i].tsc;
         game_update();
     }
 }
@@ -1090,577 +610,150 @@ void brick_gravity_fall() {
  * Rotates current falling brick.
  */
 void brick_rotate() {
-	switch(brick->type) {
-	case I:
-		if (brick->x <= 0) {
-			return;
-		}
-		if (brick->x >= FIELD_WIDTH - 3) {
-			return;
-		}
-		if (field[brick->x-1][brick->y+1] == OTHER_CHAR ||
-			field[brick->x+1][brick->y+1] == OTHER_CHAR ||
-			field[brick->x+2][brick->y+1] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_I(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = I_90;
-		brick->x = brick->x - 1;
-		brick->y = brick->y + 1;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_I_90(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case I_90:
-		if (brick->y <= 0) {
-			return;
-		}
-		if (brick->y >= FIELD_HEIGHT - 2) {
-			return;
-		}
-		if (field[brick->x+1][brick->y-1] == OTHER_CHAR ||
-			field[brick->x+1][brick->y+1] == OTHER_CHAR ||
-			field[brick->x+1][brick->y+2] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_I_90(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = I;
-		brick->x = brick->x + 1;
-		brick->y = brick->y - 1;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_I(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case J:
-		if (brick->x <= 0) {
-			return;
-		}
-		if (brick->x >= FIELD_WIDTH - 2) {
-			return;
-		}
-		if (field[brick->x][brick->y] == OTHER_CHAR ||
-			field[brick->x][brick->y+1] == OTHER_CHAR ||
-			field[brick->x+2][brick->y+1] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_J(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = J_90;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_J_90(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case J_90:
-		if (brick->x <= 0) {
-			return;
-		}
-		if (brick->y >= FIELD_HEIGHT - 2) {
-			return;
-		}
-		if (field[brick->x+1][brick->y] == OTHER_CHAR ||
-			field[brick->x][brick->y+2] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_J_90(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = J_180;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_J_180(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case J_180:
-		if (brick->x <= 0) {
-			return;
-		}
-		if (brick->x >= FIELD_WIDTH - 2) {
-			return;
-		}
-		if (field[brick->x+2][brick->y] == OTHER_CHAR ||
-			field[brick->x][brick->y+2] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_J_180(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = J_270;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_J_270(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case J_270:
-		if (brick->x <= 0) {
-			return;
-		}
-		if (brick->y >= FIELD_HEIGHT - 2) {
-			return;
-		}
-		if (field[brick->x][brick->y+2] == OTHER_CHAR ||
-			field[brick->x+1][brick->y+2] == OTHER_CHAR ||
-			field[brick->x+1][brick->y+1] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_J_270(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = J;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_J(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case L:
-		if (brick->x <= 0) {
-			return;
-		}
-		if (brick->x >= FIELD_WIDTH - 2) {
-			return;
-		}
-		if (field[brick->x+1][brick->y] == OTHER_CHAR ||
-			field[brick->x+2][brick->y] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_L(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = L_90;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_L_90(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case L_90:
-		if (brick->x <= 0) {
-			return;
-		}
-		if (brick->y >= FIELD_HEIGHT - 2) {
-			return;
-		}
-		if (field[brick->x+1][brick->y+1] == OTHER_CHAR ||
-			field[brick->x+1][brick->y+2] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_L_90(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = L_180;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_L_180(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case L_180:
-		if (brick->x <= 0) {
-			return;
-		}
-		if (brick->x >= FIELD_WIDTH - 2) {
-			return;
-		}
-		if (field[brick->x][brick->y+1] == OTHER_CHAR ||
-			field[brick->x+2][brick->y+1] == OTHER_CHAR ||
-			field[brick->x+2][brick->y] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_L_180(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = L_270;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_L_270(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case L_270:
-		if (brick->x <= 0) {
-			return;
-		}
-		if (brick->y >= FIELD_HEIGHT - 2) {
-			return;
-		}
-		if (field[brick->x+1][brick->y+1] == OTHER_CHAR ||
-			field[brick->x+2][brick->y+1] == OTHER_CHAR ||
-			field[brick->x+2][brick->y] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_L_270(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = L;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_L(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case O:
-		break;
-	case S:
-		if (brick->x < 0) {
-			return;
-		}
-		if (brick->y >= FIELD_HEIGHT - 2) {
-			return;
-		}
-		if (field[brick->x][brick->y] == OTHER_CHAR ||
-			field[brick->x+1][brick->y+2] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_S(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = S_90;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_S_90(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case S_90:
-		if (brick->x < 0) {
-			return;
-		}
-		if (brick->x >= FIELD_WIDTH - 2) {
-			return;
-		}
-		if (field[brick->x+1][brick->y] == OTHER_CHAR ||
-			field[brick->x+2][brick->y] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_S_90(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = S;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_S(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case T:
-		if (brick->x < 0) {
-			return;
-		}
-		if (brick->y >= FIELD_HEIGHT - 2) {
-			return;
-		}
-		if (field[brick->x+1][brick->y+1] == OTHER_CHAR ||
-			field[brick->x+2][brick->y+2] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_T(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = T_90;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_T_90(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case T_90:
-		if (brick->x < 0) {
-			return;
-		}
-		if (brick->x >= FIELD_WIDTH - 2) {
-			return;
-		}
-		if (field[brick->x+2][brick->y+1] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_T_90(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = T_180;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_T_180(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case T_180:
-		if (brick->x < 0) {
-			return;
-		}
-		if (brick->y >= FIELD_HEIGHT - 2) {
-			return;
-		}
-		if (field[brick->x][brick->y] == OTHER_CHAR ||
-			field[brick->x][brick->y+2] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_T_180(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = T_270;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_T_270(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case T_270:
-		if (brick->x < 0) {
-			return;
-		}
-		if (brick->x >= FIELD_WIDTH - 2) {
-			return;
-		}
-		if (field[brick->x+1][brick->y] == OTHER_CHAR ||
-			field[brick->x+2][brick->y] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_T_270(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = T;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_T(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case Z:
-		if (brick->x < 0) {
-			return;
-		}
-		if (brick->y >= FIELD_HEIGHT - 2) {
-			return;
-		}
-		if (field[brick->x][brick->y+1] == OTHER_CHAR ||
-			field[brick->x][brick->y+2] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_Z(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = Z_90;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_Z_90(brick->x, brick->y, BRICK_CHAR);
-		break;
-	case Z_90:
-		if (brick->x < 0) {
-			return;
-		}
-		if (brick->x >= FIELD_WIDTH - 2) {
-			return;
-		}
-		if (field[brick->x][brick->y] == OTHER_CHAR ||
-			field[brick->x+2][brick->y+1] == OTHER_CHAR)
-		{
-			return;
-		}
-		draw_Z_90(brick->x, brick->y, EMPTY_CHAR);
-		brick->type = Z;
-		brick->next_x = brick->x;
-		brick->next_y = brick->y;
-		draw_Z(brick->x, brick->y, BRICK_CHAR);
-		break;
-	}
+    struct BrickDef* def = &bricks[brick->type];
+    int rot = (brick->rot + 1) % def->num_rots;
+    for (int i = 0; i < def->num_kicks; i++) {
+        int x = brick->x + def->kicks[brick->rot][i][0];
+        int y = brick->y + def->kicks[brick->rot][i][1];
+        if (!brick_collides(brick->type, rot, x, y)) {
+            brick->rot = rot;
+            brick->x = brick->next_x = x;
+            brick->y = brick->next_y = y;
+            return;
+        }
+    }
 }
 
 /*
  * Creates new random brick at the middle of top of game field.
  */
 void brick_spawn() {
-	brick->type = brick->next_type;
-    brick->next_type = brick_types[(rand()) % NUM_BRICKS];
-    brick->x = FIELD_WIDTH / 2;
-    brick->y = 0;
+    brick->type = brick->next_type;
+    brick->rot = 0;
+    brick->next_type = rand() % NUM_BRICKS;
+    brick->x = FIELD_WIDTH / 2 + bricks[brick->type].spawn_x;
+    brick->y = bricks[brick->type].spawn_y;
     brick->next_x = brick->x;
     brick->next_y = brick->y;
 }
 
 /*
- * Prints brick of type I with top-left corner at (x,y) with char c.
- */
-void draw_I(int x, int y, char c) {
-    field[x][y] = c;
-    field[x][y+1] = c;
-    field[x][y+2] = c;
-    field[x][y+3] = c;
-}
-
-/*
- * Prints brick of type I_90 with top-left corner at (x,y) with char c.
- */
-void draw_I_90(int x, int y, char c) {
-    field[x][y] = c;
-    field[x+1][y] = c;
-    field[x+2][y] = c;
-    field[x+3][y] = c;
-}
-
-/*
- * Prints brick of type J with top-left corner at (x,y) with char c.
- */
-void draw_J(int x, int y, char c) {
-    field[x+1][y] = c;
-    field[x+1][y+1] = c;
-    field[x+1][y+2] = c;
-    field[x][y+2] = c;    
-}
-
-/*
- * Prints brick of type J_90 with top-left corner at (x,y) with char c.
+ * Builds row masks of all bricks from their cells.
  */
-void draw_J_90(int x, int y, char c) {
-    field[x][y] = c;
-    field[x][y+1] = c;
-    field[x+1][y+1] = c;
-    field[x+2][y+1] = c;    
-}
-
-/*
- * Prints brick of type J_180 with top-left corner at (x,y) with char c.
- */
-void draw_J_180(int x, int y, char c) {
-    field[x][y] = c;
-    field[x+1][y] = c;
-    field[x][y+1] = c;
-    field[x][y+2] = c;    
-}
-
-/*
- * Prints brick of type J_270 with top-left corner at (x,y) with char c.
- */
-void draw_J_270(int x, int y, char c) {
-    field[x][y] = c;
-    field[x+1][y] = c;
-    field[x+2][y] = c;
-    field[x+2][y+1] = c;    
-}
-
-/*
- * Prints brick of type L with top-left corner at (x,y) with char c.
- */
-void draw_L(int x, int y, char c) {
-    field[x][y] = c;
-    field[x][y+1] = c;
-    field[x][y+2] = c;
-    field[x+1][y+2] = c;    
-}
-
-/*
- * Prints brick of type L_90 with top-left corner at (x,y) with char c.
- */
-void draw_L_90(int x, int y, char c) {
-    field[x][y] = c;
-    field[x+1][y] = c;
-    field[x+2][y] = c;
-    field[x][y+1] = c;   
-}
-
-/*
- * Prints brick of type L_180 with top-left corner at (x,y) with char c.
- */
-void draw_L_180(int x, int y, char c) {
-    field[x][y] = c;
-    field[x+1][y] = c;
-    field[x+1][y+1] = c;
-    field[x+1][y+2] = c;    
-}
-
-/*
- * Prints brick of type L_270 with top-left corner at (x,y) with char c.
- */
-void draw_L_270(int x, int y, char c) {
-    field[x][y+1] = c;
-    field[x+1][y+1] = c;
-    field[x+2][y+1] = c;
-    field[x+2][y] = c;    
+void bricks_init() {
+    memset(brick_rows, 0, sizeof(brick_rows));
+    for (int t = 0; t < NUM_BRICKS; t++) {
+        for (int r = 0; r < bricks[t].num_rots; r++) {
+            for (int i = 0; i < BRICK_CELLS; i++) {
+                char* cell = bricks[t].rots[r].cells[i];
+                brick_rows[t][r][(int)cell[1]] |= 1 << cell[0];
+            }
+        }
+    }
 }
 
 /*
- * Prints brick of type O with top-left corner at (x,y) with char c.
+ * Checks if brick of given type and rotation with top-left corner
+ * at (x,y) leaves game field or overlaps landed bricks.
  */
-void draw_O(int x, int y, char c) {
-    field[x][y] = c;
-    field[x+1][y] = c;
-    field[x][y+1] = c;
-    field[x+1][y+1] = c; 
+char brick_collides(int type, int rot, int x, int y) {
+    struct BrickRot* shape = &bricks[type].rots[rot];
+    if (x < 0 || x > FIELD_WIDTH - shape->w ||
+            y < 0 || y > FIELD_HEIGHT - shape->h) {
+        return 1;
+    }
+    for (int i = 0; i < shape->h; i++) {
+        if (field[y + i] & (brick_rows[type][rot][i] << x)) {
+            return 1;
+        }
+    }
+    return 0;
 }
 
 /*
- * Prints brick of type S with top-left corner at (x,y) with char c.
+ * Returns mask of falling brick cells in given row of game field.
  */
-void draw_S(int x, int y, char c) {
-    field[x+1][y] = c;
-    field[x+2][y] = c;
-    field[x][y+1] = c;
-    field[x+1][y+1] = c; 
+unsigned short brick_row(int row) {
+    int i = row - brick->y;
+    if (i < 0 || i >= bricks[brick->type].rots[brick->rot].h) {
+        return 0;
+    }
+    return brick_rows[brick->type][brick->rot][i] << brick->x;
 }
 
 /*
- * Prints brick of type S_90 with top-left corner at (x,y) with char c.
+ * Lands falling brick on game field.
  */
-void draw_S_90(int x, int y, char c) {
-    field[x][y] = c;
-    field[x][y+1] = c;
-    field[x+1][y+1] = c;
-    field[x+1][y+2] = c; 
+void brick_place() {
+    for (int i = 0; i < bricks[brick->type].rots[brick->rot].h; i++) {
+        field[brick->y + i] |= brick_rows[brick->type][brick->rot][i] << brick->x;
+    }
 }
 
 /*
- * Prints brick of type Z with top-left corner at (x,y) with char c.
+ * Draws unrotated brick of given type with top-left corner at
+ * screen position (x,y).
  */
-void draw_Z(int x, int y, char c) {
-    field[x][y] = c;
-    field[x+1][y] = c;
-    field[x+1][y+1] = c;
-    field[x+2][y+1] = c; 
+void brick_preview(int type, int x, int y) {
+    for (int i = 0; i < BRICK_CELLS; i++) {
+        move_cursor(x + bricks[type].rots[0].cells[i][0], y + bricks[type].rots[0].cells[i][1]);
+        putchar(BRICK_CHAR);
+    }
 }
 
 /*
- * Prints brick of type Z_90 with top-left corner at (x,y) with char c.
+ * Checks for completed rows and deletes them if found.
+ * Rows above a deleted one move down.
  */
-void draw_Z_90(int x, int y, char c) {
-    field[x+1][y] = c;
-    field[x][y+1] = c;
-    field[x+1][y+1] = c;
-    field[x][y+2] = c; 
+void rows_delete_completed() {
+    int k = FIELD_HEIGHT - 1;
+    for (int i = FIELD_HEIGHT - 1; i >= 0; i--) {
+        if (field[i] == FULL_ROW) {
+            rows_completed++;
+            continue;
+        }
+        field[k--] = field[i];
+    }
+    while (k >= 0) {
+        field[k--] = 0;
+    }
 }
 
-/*
- * Prints brick of type T with top-left corner at (x,y) with char c.
- */
-void draw_T(int x, int y, char c) {
-    field[x][y] = c;
-    field[x+1][y] = c;
-    field[x+2][y] = c;
-    field[x+1][y+1] = c; 
-}
 
-/*
- * Prints brick of type T_90 with top-left corner at (x,y) with char c.
- */
-void draw_T_90(int x, int y, char c) {
-    field[x+1][y] = c;
-    field[x][y+1] = c;
-    field[x+1][y+1] = c;
-    field[x+1][y+2] = c; 
+static void bench_video_update(void* arg) {
+    video_update();
 }
 
-/*
- * Prints brick of type T_180 with top-left corner at (x,y) with char c.
- */
-void draw_T_180(int x, int y, char c) {
-    field[x+1][y] = c;
-    field[x][y+1] = c;
-    field[x+1][y+1] = c;
-    field[x+2][y+1] = c; 
+static void bench_game_update(void* arg) {
+    game_update();
 }
 
-/*
- * Prints brick of type T_270 with top-left corner at (x,y) with char c.
- */
-void draw_T_270(int x, int y, char c) {
-    field[x][y] = c;
-    field[x][y+1] = c;
-    field[x+1][y+1] = c;
-    field[x][y+2] = c; 
+static void bench_rows_delete_completed(void* arg) {
+    rows_delete_completed();
 }
 
-/*
- * Deletes a completed row from game field.
- */
-void row_delete(int row) {
-    for (int k = row - 1; k >= 0; k--) {
-        for (int j = 0; j < FIELD_WIDTH; j++) {
-            if (field[j][k+1] != BRICK_CHAR && field[j][k] != BRICK_CHAR) {
-                field[j][k+1] = field[j][k];
+/* one collision test of every brick rotation in every column */
+static void bench_brick_collides(void* arg) {
+    for (int t = 0; t < NUM_BRICKS; t++) {
+        for (int r = 0; r < bricks[t].num_rots; r++) {
+            for (int x = 0; x < FIELD_WIDTH; x++) {
+                brick_collides(t, r, x, FIELD_HEIGHT / 2 - 1);
             }
         }
     }
 }
 
 /*
- * Checks for completed rows and deletes them if found.
+ * Registers benchmarks of game functions. Game must be initialized.
+ * Bottom half of the field gets filled except one column,
+ * so rows are scanned fully but never deleted.
  */
-void rows_delete_completed() {
-    for (int i = FIELD_HEIGHT - 1; i >= 0; i--) {
-        int c = 0;
-        for (int j = 0; j < FIELD_WIDTH; j++) {
-            if (field[j][i] == OTHER_CHAR) {
-                c++;
-            }
-        }
-        if (c == FIELD_WIDTH) {
-            rows_completed++;
-            row_delete(i);
-            i--;
-            continue;
-        }
+void game_bench_register() {
+    for (int i = FIELD_HEIGHT / 2; i < FIELD_HEIGHT; i++) {
+        field[i] = FULL_ROW & ~1;
     }
+    bench_register("video_update", bench_video_update, NULL, 4);
+    bench_register("game_update", bench_game_update, NULL, 64);
+    bench_register("rows_delete_completed", bench_rows_delete_completed, NULL, 64);
+    bench_register("brick_collides", bench_brick_collides, NULL, 64);
 }
-
@@ -1,7 +1,11 @@
     .text
     .global loader                   # making entry point visible to linker
 
+    .ifdef GFX
+    .set FLAGS,    0x4               # this is the Multiboot 'flag' field, video mode wanted
+    .else
     .set FLAGS,    0x0               # this is the Multiboot 'flag' field
+    .endif
     .set MAGIC,    0x1BADB002        # 'magic number' lets bootloader find the header
     .set CHECKSUM, -(MAGIC + FLAGS)  # checksum required
 
@@ -9,16 +13,26 @@
     .long MAGIC
     .long FLAGS
     .long CHECKSUM
+    .ifdef GFX
+    .long 0, 0, 0, 0, 0              # address fields, unused for ELF kernel
+    .long 0                          # linear graphics mode
+    .long GFX_WIDTH, GFX_HEIGHT, 32  # preferred width, height and depth
+    .endif
 
 # reserve initial kernel stack space
     .set STACKSIZE, 0x4000           # that is, 16k.
     .lcomm stack, STACKSIZE          # reserve 16k stack
     .comm  mbd, 4                    
     .comm  magic, 4                 
+    .comm  boot_tsc, 8               # time stamp counter at entry
 
 loader:
-    movl  $(stack + STACKSIZE), %esp # set up the stack
     movl  %eax, magic                # Multiboot magic number
+    rdtsc                            # boot start time for boot report
+    movl  %eax, boot_tsc
+    movl  %edx, boot_tsc + 4
+    movl  $(stack + STACKSIZE), %esp # set up the stack
+    movl  magic, %eax
     movl  %ebx, mbd                  # Multiboot data structure
     pushl %eax                       # 'mbd'   arg to main func 
     pushl %ebx                       # 'magic' arg to main func
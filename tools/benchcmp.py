@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""
+Stores benchmark baselines and compares new runs against them.
+
+Input is the output of 'make bench' (BENCH/SAMPLES lines).
+
+  tools/benchcmp.py save bin/bench.txt      store samples as baseline
+  tools/benchcmp.py compare bin/bench.txt   compare run with baseline
+
+Baseline is a JSON file (bench/baseline.json by default) holding raw
+samples of every benchmark, so runs are compared sample against sample:
+Mann-Whitney U test tells whether the difference is real, bootstrap
+confidence interval of median ratio tells how large it is.
+A benchmark regresses when the difference is significant and the whole
+confidence interval lies above 1 + threshold.
+'compare' exits with status 1 if any benchmark regressed.
+"""
+
+import argparse
+import json
+import math
+import os
+import random
+import statistics
+import subprocess
+import sys
+import time
+
+DEFAULT_BASELINE = os.path.join(os.path.dirname(__file__), "..", "bench", "baseline.json")
+
+
+def parse_run(path):
+    """Returns ({name: [samples]}, {header key: value}) from bench output."""
+    samples, header = {}, {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            words = line.split()
+            if not words:
+                continue
+            if words[0] == "BENCH_START":
+                header = dict(w.split("=", 1) for w in words[1:] if "=" in w)
+            elif words[0] == "SAMPLES" and words[1].startswith("name="):
+                samples[words[1][5:]] = [int(w) for w in words[2:]]
+    if not samples:
+        sys.exit("%s: no SAMPLES lines, is it output of 'make bench'?" % path)
+    return samples, header
+
+
+def git_revision():
+    try:
+        return subprocess.run(["git", "rev-parse", "--short", "HEAD"], capture_output=True,
+                              text=True, check=True).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def mann_whitney(a, b):
+    """Two-sided Mann-Whitney U test, normal approximation with tie correction.
+    Returns p-value."""
+    n1, n2 = len(a), len(b)
+    ranked = sorted([(x, 0) for x in a] + [(x, 1) for x in b])
+    ranks = [0.0] * len(ranked)
+    ties = 0.0
+    i = 0
+    while i < len(ranked):
+        j = i
+        while j + 1 < len(ranked) and ranked[j + 1][0] == ranked[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2.0 + 1
+        t = j - i + 1
+        ties += t ** 3 - t
+        i = j + 1
+    r1 = sum(r for r, (_, group) in zip(ranks, ranked) if group == 0)
+    u = r1 - n1 * (n1 + 1) / 2.0
+    n = n1 + n2
+    sigma = math.sqrt(n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1))))
+    if sigma == 0:
+        return 1.0
+    z = (abs(u - n1 * n2 / 2.0) - 0.5) / sigma
+    return math.erfc(max(z, 0) / math.sqrt(2))
+
+
+def bootstrap_ratio(base, new, confidence, rounds, rng):
+    """Bootstrap confidence interval of median(new) / median(base)."""
+    ratios = []
+    for _ in range(rounds):
+        b = statistics.median(rng.choices(base, k=len(base)))
+        n = statistics.median(rng.choices(new, k=len(new)))
+        ratios.append(n / b if b else float("inf"))
+    ratios.sort()
+    lo = ratios[int((1 - confidence) / 2 * rounds)]
+    hi = ratios[min(rounds - 1, int((1 + confidence) / 2 * rounds))]
+    return lo, hi
+
+
+def save(args):
+    samples, header = parse_run(args.run)
+    baseline = {"benchmarks": {}}
+    if os.path.exists(args.baseline) and not args.replace:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    for name, values in samples.items():
+        baseline["benchmarks"][name] = {
+            "samples": values,
+            "median": statistics.median(values),
+            "revision": git_revision(),
+            "date": time.strftime("%Y-%m-%d"),
+            "tsc_khz": int(header.get("tsc_khz", 0)),
+        }
+    os.makedirs(os.path.dirname(os.path.abspath(args.baseline)), exist_ok=True)
+    with open(args.baseline, "w") as f:
+        json.dump(baseline, f, indent=1, sort_keys=True)
+        f.write("\n")
+    print("saved %d benchmarks to %s" % (len(samples), args.baseline))
+
+
+def compare(args):
+    samples, header = parse_run(args.run)
+    with open(args.baseline) as f:
+        baseline = json.load(f)["benchmarks"]
+    rng = random.Random(args.seed)
+    limit = 1 + args.threshold / 100.0
+    regressions = 0
+    print("%-28s %10s %10s %8s %17s %8s  %s" %
+          ("benchmark", "base", "new", "change", "%d%% CI" % round(args.confidence * 100),
+           "p", "verdict"))
+    for name in sorted(samples):
+        new = samples[name]
+        if name not in baseline:
+            print("%-28s %10s %10g %8s %17s %8s  new" % (name, "-", statistics.median(new), "", "", ""))
+            continue
+        base = baseline[name]["samples"]
+        khz = baseline[name].get("tsc_khz", 0)
+        if khz and header.get("tsc_khz") and abs(int(header["tsc_khz"]) - khz) > khz / 10:
+            print("warning: %s baseline was taken at tsc_khz=%d, run has %s"
+                  % (name, khz, header["tsc_khz"]), file=sys.stderr)
+        mb, mn = statistics.median(base), statistics.median(new)
+        p = mann_whitney(base, new)
+        lo, hi = bootstrap_ratio(base, new, args.confidence, args.rounds, rng)
+        verdict = "ok"
+        if p < args.alpha and lo > limit:
+            verdict = "REGRESSION"
+            regressions += 1
+        elif p < args.alpha and hi < 1 / limit:
+            verdict = "faster"
+        change = (mn / mb - 1) * 100 if mb else float("inf")
+        print("%-28s %10g %10g %+7.1f%% %8.3f..%-7.3f %8.4f  %s" %
+              (name, mb, mn, change, lo, hi, p, verdict))
+    for name in sorted(set(baseline) - set(samples)):
+        print("%-28s %10g %10s %8s %17s %8s  missing" % (name, baseline[name]["median"], "-", "", "", ""))
+    if regressions:
+        print("%d benchmark(s) regressed by more than %g%%" % (regressions, args.threshold))
+        return 1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE, help="baseline file")
+    sub = parser.add_subparsers(dest="command", required=True)
+    p = sub.add_parser("save", help="store run as baseline")
+    p.add_argument("run")
+    p.add_argument("--replace", action="store_true", help="drop benchmarks missing in run")
+    p = sub.add_parser("compare", help="compare run with baseline")
+    p.add_argument("run")
+    p.add_argument("--threshold", type=float, default=5.0, help="allowed slowdown, percent")
+    p.add_argument("--alpha", type=float, default=0.01, help="significance level")
+    p.add_argument("--confidence", type=float, default=0.95, help="bootstrap confidence level")
+    p.add_argument("--rounds", type=int, default=2000, help="bootstrap resamples")
+    p.add_argument("--seed", type=int, default=1, help="bootstrap random seed")
+    args = parser.parse_args()
+    if args.command == "save":
+        save(args)
+        return 0
+    return compare(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+"""
+Replaces function addresses in Chrome trace-event JSON exported by
+trace_export() with symbol names taken from the kernel image.
+
+Usage: tools/trace_symbolize.py bin/kernel.bin trace.json > named.json
+Open the result in chrome://tracing or https://ui.perfetto.dev.
+"""
+
+import json
+import subprocess
+import sys
+
+
+def load_symbols(kernel):
+    out = subprocess.run(["nm", kernel], check=True, capture_output=True, text=True).stdout
+    symbols = {}
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) == 3 and parts[1] in "tT":
+            symbols[int(parts[0], 16)] = parts[2]
+    return symbols
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__.strip())
+    symbols = load_symbols(sys.argv[1])
+    with open(sys.argv[2]) as f:
+        trace = json.load(f)
+    for event in trace["traceEvents"]:
+        name = event["name"]
+        if name.startswith("0x"):
+            event["name"] = symbols.get(int(name, 16), name)
+    json.dump(trace, sys.stdout, indent=1)
+
+
+if __name__ == "__main__":
+    main()